@@ -0,0 +1,48 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace glacie::bench {
+
+// keep the compiler from dropping a result which is not used otherwise
+template <class T>
+inline void doNotOptimize(T const& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+/**
+ * @brief Measure the average time of one call of fn in nanoseconds.
+ * @details The calls are repeated in rounds after a warm-up, and the fastest round is taken so
+ * that preemption does not skew the result.
+ */
+template <class F>
+double measureNs(size_t iterations, F&& fn) {
+    for (size_t i = 0; i < iterations / 10; ++i) fn();
+    double best = 1e300;
+    for (int round = 0; round < 5; ++round) {
+        auto begin = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) fn();
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        best         = std::min(best, elapsed / (double)iterations);
+    }
+    return best;
+}
+
+/**
+ * @brief Get the value below which the given share of the samples lie, the samples are reordered.
+ */
+inline uint64_t getPercentile(std::vector<uint64_t>& samples, double share) {
+    if (samples.empty()) { return 0; }
+    auto index = std::min(samples.size() - 1, (size_t)(share * (double)samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + (ptrdiff_t)index, samples.end());
+    return samples[index];
+}
+
+inline void printResult(char const* name, double ns) { std::printf("%-40s %10.2f ns\n", name, ns); }
+
+} // namespace glacie::bench
\ No newline at end of file
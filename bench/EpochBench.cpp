@@ -0,0 +1,55 @@
+#include "glacie/memory/Epoch.h"
+#include "glacie/memory/Hook.h"
+
+#include <cstdio>
+
+#include "Bench.h"
+
+using namespace glacie::memory;
+using namespace glacie::bench;
+
+// returns value + 1, the 5 byte first instruction lets the prologue be replaced by a single store
+extern "C" int glacieEpochBenchTarget(int value);
+asm(R"(
+.text
+.p2align 4
+.globl glacieEpochBenchTarget
+glacieEpochBenchTarget:
+    mov $1, %eax
+    add %edi, %eax
+    ret
+)");
+
+GLACIE_STATIC_HOOK(EpochBenchHook, &glacieEpochBenchTarget, int, int value) { return origin(value); }
+
+constexpr size_t ITERATIONS = 20'000'000;
+
+int main() {
+    int (*volatile target)(int) = &glacieEpochBenchTarget;
+    int sum                     = 0;
+
+    printResult("direct call", measureNs(ITERATIONS, [&] { sum += target(sum); }));
+    printResult("EpochGuard", measureNs(ITERATIONS, [] {
+                    EpochGuard guard;
+                    doNotOptimize(guard);
+                }));
+    // without a process-wide barrier every guard has to fence itself
+    auto needsFence = epochNeedsFence.exchange(true);
+    printResult("EpochGuard with fence", measureNs(ITERATIONS, [] {
+                    EpochGuard guard;
+                    doNotOptimize(guard);
+                }));
+    epochNeedsFence.store(needsFence);
+
+    if (EpochBenchHook::hook() != 0) {
+        std::fprintf(stderr, "cannot hook the target\n");
+        return 1;
+    }
+    // prologue jump, thunk, dispatch with its guard, detour and trampoline
+    printResult("hooked call", measureNs(ITERATIONS, [&] { sum += target(sum); }));
+    EpochBenchHook::unhook();
+    synchronizeEpoch();
+    printResult("call after unhook", measureNs(ITERATIONS, [&] { sum += target(sum); }));
+    doNotOptimize(sum);
+    return 0;
+}
\ No newline at end of file
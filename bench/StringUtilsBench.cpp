@@ -0,0 +1,55 @@
+#include "glacie/utils/StringUtils.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include "Bench.h"
+
+using namespace glacie::utils::string_utils;
+using namespace glacie::bench;
+
+namespace {
+
+// roughly one byte in 16 starts a pattern, the rest is spread over the lower case letters
+std::string makeInput(size_t size) {
+    constexpr char specials[] = {'<', '>', '&', '"'};
+    std::string    result(size, ' ');
+    uint32_t       state = 12345;
+    for (auto& c : result) {
+        state = state * 1664525 + 1013904223;
+        auto r = state >> 24;
+        c      = r < 16 ? specials[r & 3] : (char)('a' + r % 26);
+    }
+    return result;
+}
+
+} // namespace
+
+int main() {
+    MultiReplacer const escaper{
+        {"&", "&amp;" },
+        {"<", "&lt;"  },
+        {">", "&gt;"  },
+        {"\"", "&quot;"},
+    };
+    std::printf("ns per input byte\n");
+    for (size_t size : {1u << 10, 1u << 16, 1u << 20, 1u << 24}) {
+        auto input      = makeInput(size);
+        auto iterations = std::max<size_t>(1, (64u << 20) / size / 8);
+        auto measure    = [&](char const* name, auto&& fn) {
+            char label[64];
+            std::snprintf(label, sizeof(label), "%s %zu KiB", name, size >> 10);
+            printResult(label, measureNs(iterations, [&] { doNotOptimize(fn()); }) / (double)size);
+        };
+        measure("replaceAll grow", [&] { return replaceAll(std::string_view{input}, "<", "&lt;"); });
+        measure("replaceAll shrink", [&] { return replaceAll(std::string_view{input}, "<", ""); });
+        measure("replaceAll in place", [&] {
+            auto copy = input;
+            replaceAll(copy, "<", ">");
+            return copy.size();
+        });
+        measure("MultiReplacer", [&] { return escaper(input); });
+    }
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string_view>
+
+#include "glacie/memory/Hook.h"
+
+namespace glacie::memory {
+
+/**
+ * @brief Hook a function of a module as soon as the module is loaded.
+ * @details If the module is already loaded, the hook is installed before returning. Otherwise the
+ * hook is installed once the module is loaded, and again whenever the module is reloaded. On Windows
+ * the signature is resolved on a worker thread once the loader reports the module, so the loading
+ * thread is not held up by the scan.
+ * @note On Windows the hook is dropped while the module is being unloaded, without restoring the code
+ * or waiting for other threads, see discardHooks. A detour which may still run then must not call the
+ * original function. On Linux the hooks are installed before dlopen returns, as long as the call binds to
+ * the dlopen of this library, which it does in the main program and in modules loaded after it. Other
+ * loads are found by a worker which rescans the loaded objects. A module with deferred hooks must stay
+ * loaded once they are installed.
+ * @param moduleName File name of the module, such as "ws2_32.dll" or "libssl.so.3"
+ * @param signature Signature of the function inside the module
+ * @return id of the deferred hook, or -1 if the module is loaded but the hook cannot be installed
+ */
+int registerDeferredHook(
+    std::string_view moduleName,
+    std::string_view signature,
+    FuncPtr          detour,
+    FuncPtr*         originalFunc
+);
+
+/**
+ * @brief Forget a deferred hook and remove it from the module if it is installed.
+ */
+bool removeDeferredHook(int id);
+
+[[nodiscard]] bool isDeferredHookInstalled(int id);
+
+} // namespace glacie::memory
\ No newline at end of file
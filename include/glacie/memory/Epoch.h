@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+namespace glacie::memory {
+
+struct EpochRecord {
+    std::atomic_uint64_t epoch{}; // 0 while the thread is outside of a guard
+    uint32_t             depth{};
+    std::atomic_bool     inUse{};
+};
+
+inline std::atomic_uint64_t globalEpoch{1};
+
+// without a process-wide barrier the readers have to fence themselves
+inline std::atomic_bool epochNeedsFence{};
+
+inline thread_local EpochRecord* currentEpochRecord{};
+
+EpochRecord& registerEpochThread();
+
+/**
+ * @brief Mark the current thread as running inside code that may be reclaimed.
+ * @details Memory retired while a guard is alive is not freed until the guard is gone.
+ * Guards can be nested and cost a thread-local load and a store on the hot path.
+ * @note Only what runs while the guard is alive is protected. The dispatch of a hook takes the
+ * guard, so the detours and the trampoline they call are covered, but the jump in the prologue,
+ * the thunk and anything else a thread passes before reaching the guard are not. Such code has
+ * to stay valid for good instead of being retired.
+ */
+class EpochGuard {
+public:
+    EpochGuard() noexcept {
+        auto record = currentEpochRecord;
+        if (!record) [[unlikely]] { record = &registerEpochThread(); }
+        if (record->depth++ == 0) {
+            record->epoch.store(globalEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            if (epochNeedsFence.load(std::memory_order_relaxed)) [[unlikely]] {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            } else {
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+            }
+        }
+    }
+    ~EpochGuard() noexcept {
+        auto record = currentEpochRecord;
+        if (--record->depth == 0) { record->epoch.store(0, std::memory_order_release); }
+    }
+
+    EpochGuard(EpochGuard const&)            = delete;
+    EpochGuard& operator=(EpochGuard const&) = delete;
+};
+
+/**
+ * @brief Call the deleter once no thread can still be inside a guard that was alive at
+ * the time of retiring.
+ * @details A background thread, started by the first call, keeps reclaiming while deleters are
+ * pending, so the deleter runs soon after the last of those guards is gone even if nobody calls
+ * reclaim() again. The deleter may run on that thread.
+ */
+void retire(std::function<void()> deleter);
+
+/**
+ * @brief Try to advance the epoch and run the deleters that became safe.
+ * @return whether nothing is left to reclaim
+ */
+bool reclaim();
+
+/**
+ * @brief Block until everything retired before the call has been reclaimed.
+ * @details Call this after unhooking and before unloading the module that holds the detours.
+ * @warning Never call this inside a guard, such as from a detour. The epoch cannot advance past
+ * the guard of the calling thread, so the call would never return.
+ */
+void synchronizeEpoch();
+
+} // namespace glacie::memory
\ No newline at end of file
@@ -1,10 +1,17 @@
 #pragma once
 
+#include <atomic>
+#include <cstring>
 #include <memory>
 #include <set>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
+#include "glacie/memory/Epoch.h"
 #include "glacie/memory/Memory.h"
+#include "glacie/memory/Timeline.h"
+#include "glacie/memory/Trace.h"
 
 namespace glacie::memory {
 
@@ -12,8 +19,34 @@ typedef void* FuncPtr;
 
 int hook(FuncPtr target, FuncPtr detour, FuncPtr* originalFunc);
 
+/**
+ * @brief Remove a detour from the call list of target.
+ * @details Threads may still run the detour when this returns. Once the last detour of target
+ * is gone, the epoch reclaimer restores the prologue of target as soon as no thread is inside a
+ * detour any more, see retire(). The thunk is kept and reused by the next hook of target, since a
+ * thread may still be on its way from the prologue to a detour. Call synchronizeEpoch() before
+ * unloading the module which contains the detour.
+ */
 bool unhook(FuncPtr target, FuncPtr detour);
 
+/**
+ * @brief Forget every detour of target without restoring its prologue, for a module which is being unloaded.
+ * @details Nothing is written to target and nothing waits for other threads, so it can be called by the
+ * loader. The thunk and the trampoline are never released, a detour which is still running must not call
+ * the original function of target any more.
+ */
+void discardHooks(FuncPtr target);
+
+/**
+ * @brief Install and remove the jumps of later hooks without suspending other threads.
+ * @details The jump is written by a single atomic store, see attachTrampoline. Targets whose
+ * prologue does not allow that fail to hook instead. On Windows the hooks are installed by the
+ * built-in trampoline instead of Detours while this is enabled.
+ */
+void setLivePatching(bool enabled);
+
+[[nodiscard]] bool isLivePatching();
+
 template <class T>
 struct IsConstMemberFun : std::false_type {};
 
@@ -42,7 +75,7 @@ using AddConstAtMemberFunIfOriginIs = std::conditional_t<IsConstMemberFunV<U>, A
 /**
  * @brief Get the pointer of a function by identifier.
  *
- * @param identifier signature
+ * @param identifier signature or symbol
  * @return FuncPtr
  */
 FuncPtr resolveIdentifier(char const* identifier);
@@ -68,10 +101,58 @@ constexpr FuncPtr resolveIdentifier(uintptr_t address) {
     return resolveIdentifier(address);
 }
 
+template <class T>
+struct DetourDispatcher;
+
+template <class Ret, class... Args>
+struct DetourDispatcher<Ret (*)(Args...)> {
+    template <class H>
+    static FuncPtr get() {
+        return toFuncPtr(&H::template dispatch<Args...>);
+    }
+};
+
+template <class T, class Ret, class... Args>
+struct DetourDispatcher<Ret (T::*)(Args...)> {
+    template <class H>
+    static FuncPtr get() {
+        return toFuncPtr(&H::template dispatch<Args...>);
+    }
+};
+
+template <class T, class Ret, class... Args>
+struct DetourDispatcher<Ret (T::*)(Args...) const> {
+    template <class H>
+    static FuncPtr get() {
+        return toFuncPtr(&H::template dispatch<Args...>);
+    }
+};
+
+/**
+ * @brief Get the function installed for the hook definition H, which wraps H::detour.
+ */
+template <class H, class OriginFuncType>
+FuncPtr getDetourDispatcher() {
+    return DetourDispatcher<OriginFuncType>::template get<H>();
+}
+
+/**
+ * @brief Read the original function of a hook definition, which hook() and updateCallList publish into its
+ * first pointer sized word with a release store.
+ */
+template <class T>
+[[nodiscard]] T loadOriginalFunc(T& originalFunc) noexcept {
+    static_assert(sizeof(T) >= sizeof(FuncPtr));
+    T    result{};
+    auto address = std::atomic_ref(*reinterpret_cast<FuncPtr*>(&originalFunc)).load(std::memory_order_acquire);
+    memcpy(&result, &address, sizeof(address));
+    return result;
+}
+
 template <class... Ts>
 class HookRegistrar {
 public:
-    static void hook() { (((++Ts::AutoHookCount == 1) ? Ts::hook() : 0), ...); }
+    static void hook() { (((++Ts::AutoHookCount == 1) ? registerHook<Ts>() : 0), ...); }
     static void unhook() { (((--Ts::AutoHookCount == 0) ? Ts::unhook() : 0), ...); }
     HookRegistrar() noexcept { hook(); }
     ~HookRegistrar() noexcept { unhook(); }
@@ -82,6 +163,86 @@ public:
     }
     HookRegistrar(HookRegistrar&&) noexcept            = default;
     HookRegistrar& operator=(HookRegistrar&&) noexcept = default;
+
+private:
+    template <class T>
+    static int registerHook() {
+        TimelineScope timeline(TimelineEventKind::HookRegistrar, T::getHookName());
+        return T::hook();
+    }
+};
+
+/**
+ * @brief Let the hooks Ts call straight through to the original function on the current thread.
+ * @details Scopes can be nested. Opening one inside a detour keeps the detour from being re-entered
+ * by the functions it calls. A thread which never needs the hooks can call Ts::suspend() once instead.
+ */
+template <class... Ts>
+class ScopedHookSuspend {
+public:
+    ScopedHookSuspend() noexcept { (Ts::suspend(), ...); }
+    ~ScopedHookSuspend() noexcept { (Ts::resume(), ...); }
+
+    ScopedHookSuspend(ScopedHookSuspend const&)            = delete;
+    ScopedHookSuspend& operator=(ScopedHookSuspend const&) = delete;
+};
+
+/**
+ * @brief Compose hooks of the same function known at compile time into a single detour.
+ * @details Every layer is a GLACIE_FUSED_*_HOOK definition. origin() of a layer calls the
+ * detour of the next layer directly, so the calls can be inlined, and only the first detour
+ * is installed. Hooks installed later at runtime are still chained after the fused block.
+ * The target is resolved from the identifier of the first layer.
+ */
+template <template <class, size_t> class... Layers>
+class FusedHookChain {
+    static_assert(sizeof...(Layers) > 0, "a fused hook chain needs at least one layer");
+
+    template <class Seq>
+    struct Instantiate;
+
+    template <size_t... Is>
+    struct Instantiate<std::index_sequence<Is...>> {
+        using type = std::tuple<Layers<FusedHookChain, Is>...>;
+    };
+
+public:
+    static constexpr size_t size = sizeof...(Layers);
+
+    template <size_t I>
+    using Layer = std::tuple_element_t<I, typename Instantiate<std::make_index_sequence<size>>::type>;
+
+    inline static ::std::atomic_uint AutoHookCount{};
+
+    inline static thread_local uint32_t SuspendCount{};
+
+    static void suspend() noexcept { ++SuspendCount; }
+
+    static void resume() noexcept { --SuspendCount; }
+
+    [[nodiscard]] static bool isSuspended() noexcept { return SuspendCount != 0; }
+
+    [[nodiscard]] static constexpr char const* getHookName() noexcept { return Layer<0>::getHookName(); }
+
+    static int hook() {
+        using First = Layer<0>;
+        using Last  = Layer<size - 1>;
+        HookTarget  = First::resolveTarget();
+        if (HookTarget == nullptr) { return -1; }
+        return glacie::memory::hook(
+            HookTarget,
+            getDetourDispatcher<First, typename First::OriginFuncType>(),
+            reinterpret_cast<FuncPtr*>(&Last::OriginalFunc)
+        );
+    }
+
+    static bool unhook() {
+        using First = Layer<0>;
+        return glacie::memory::unhook(HookTarget, getDetourDispatcher<First, typename First::OriginFuncType>());
+    }
+
+private:
+    inline static FuncPtr HookTarget{};
 };
 
 struct Hook {};
@@ -101,6 +262,9 @@ struct Hook {};
                                                                                                                        \
         inline static FuncPtr        HookTarget{};                                                                     \
         inline static OriginFuncType OriginalFunc{};                                                                   \
+        inline static uint32_t       TraceSource{};                                                                    \
+                                                                                                                       \
+        inline static thread_local uint32_t SuspendCount{};                                                            \
                                                                                                                        \
     public:                                                                                                            \
         template <class... Args>                                                                                       \
@@ -110,18 +274,40 @@ struct Hook {};
                                                                                                                        \
         STATIC RET_TYPE detour(__VA_ARGS__);                                                                           \
                                                                                                                        \
+        template <class... Args>                                                                                       \
+        STATIC RET_TYPE dispatch(Args... params) {                                                                     \
+            ::glacie::memory::EpochGuard guard;                                                                        \
+            if (SuspendCount) [[unlikely]] { return origin(std::forward<Args>(params)...); }                           \
+            ::glacie::memory::HookTraceScope<::glacie::memory::hookTraceEnabled> trace(TraceSource);                   \
+            return detour(std::forward<Args>(params)...);                                                              \
+        }                                                                                                              \
+                                                                                                                       \
+        static void suspend() noexcept { ++SuspendCount; }                                                             \
+                                                                                                                       \
+        static void resume() noexcept { --SuspendCount; }                                                              \
+                                                                                                                       \
+        [[nodiscard]] static bool isSuspended() noexcept { return SuspendCount != 0; }                                 \
+                                                                                                                       \
+        [[nodiscard]] static constexpr char const* getHookName() noexcept { return #DEF_TYPE; }                        \
+                                                                                                                       \
         static int hook() {                                                                                            \
             HookTarget = glacie::memory::resolveIdentifier<OriginFuncType>(IDENTIFIER);                                \
             if (HookTarget == nullptr) { return -1; }                                                                  \
+            if constexpr (::glacie::memory::hookTraceEnabled) {                                                        \
+                TraceSource = ::glacie::memory::registerTraceSource(#DEF_TYPE);                                        \
+            }                                                                                                          \
             return glacie::memory::hook(                                                                               \
                 HookTarget,                                                                                            \
-                glacie::memory::toFuncPtr(&DEF_TYPE::detour),                                                          \
+                glacie::memory::getDetourDispatcher<DEF_TYPE, OriginFuncType>(),                                       \
                 reinterpret_cast<FuncPtr*>(&OriginalFunc)                                                              \
             );                                                                                                         \
         }                                                                                                              \
                                                                                                                        \
         static bool unhook() {                                                                                         \
-            return glacie::memory::unhook(HookTarget, glacie::memory::toFuncPtr(&DEF_TYPE::detour));                   \
+            return glacie::memory::unhook(                                                                             \
+                HookTarget,                                                                                            \
+                glacie::memory::getDetourDispatcher<DEF_TYPE, OriginFuncType>()                                        \
+            );                                                                                                         \
         }                                                                                                              \
     };                                                                                                                 \
     REGISTER;                                                                                                          \
@@ -139,15 +325,85 @@ struct Hook {};
 
 #define GLACIE_MANUAL_REG_HOOK_IMPL(...) VA_EXPAND(GLACIE_HOOK_IMPL(, __VA_ARGS__))
 
-#define GLACIE_STATIC_HOOK_IMPL(...) VA_EXPAND(GLACIE_MANUAL_REG_HOOK_IMPL((*), static, OriginalFunc, __VA_ARGS__))
+#define GLACIE_STATIC_HOOK_IMPL(...)                                                                                   \
+    VA_EXPAND(GLACIE_MANUAL_REG_HOOK_IMPL((*), static, ::glacie::memory::loadOriginalFunc(OriginalFunc), __VA_ARGS__))
 
-#define GLACIE_AUTO_STATIC_HOOK_IMPL(...) VA_EXPAND(GLACIE_AUTO_REG_HOOK_IMPL((*), static, OriginalFunc, __VA_ARGS__))
+#define GLACIE_AUTO_STATIC_HOOK_IMPL(...)                                                                              \
+    VA_EXPAND(GLACIE_AUTO_REG_HOOK_IMPL((*), static, ::glacie::memory::loadOriginalFunc(OriginalFunc), __VA_ARGS__))
 
 #define GLACIE_INSTANCE_HOOK_IMPL(DEF_TYPE, ...)                                                                       \
-    VA_EXPAND(GLACIE_MANUAL_REG_HOOK_IMPL((DEF_TYPE::*), , (this->*OriginalFunc), DEF_TYPE, __VA_ARGS__))
+    VA_EXPAND(GLACIE_MANUAL_REG_HOOK_IMPL(                                                                             \
+        (DEF_TYPE::*),                                                                                                 \
+        ,                                                                                                              \
+        (this->*::glacie::memory::loadOriginalFunc(OriginalFunc)),                                                     \
+        DEF_TYPE,                                                                                                      \
+        __VA_ARGS__                                                                                                    \
+    ))
 
 #define GLACIE_AUTO_INSTANCE_HOOK_IMPL(DEF_TYPE, ...)                                                                  \
-    VA_EXPAND(GLACIE_AUTO_REG_HOOK_IMPL((DEF_TYPE::*), , (this->*OriginalFunc), DEF_TYPE, __VA_ARGS__))
+    VA_EXPAND(GLACIE_AUTO_REG_HOOK_IMPL(                                                                               \
+        (DEF_TYPE::*),                                                                                                 \
+        ,                                                                                                              \
+        (this->*::glacie::memory::loadOriginalFunc(OriginalFunc)),                                                     \
+        DEF_TYPE,                                                                                                      \
+        __VA_ARGS__                                                                                                    \
+    ))
+
+#define GLACIE_FUSED_HOOK_IMPL(FUNC_PTR, STATIC, CALL, NEXT, DEF_TYPE, TYPE, IDENTIFIER, RET_TYPE, ...)                \
+    template <class Chain, size_t Index>                                                                               \
+    struct DEF_TYPE : public TYPE {                                                                                    \
+        template <template <class, size_t> class...>                                                                   \
+        friend class ::glacie::memory::FusedHookChain;                                                                 \
+                                                                                                                       \
+    private:                                                                                                           \
+        using FuncPtr = ::glacie::memory::FuncPtr;                                                                     \
+        using OriginFuncType =                                                                                         \
+            ::glacie::memory::AddConstAtMemberFunIfOriginIs<RET_TYPE FUNC_PTR(__VA_ARGS__), decltype(IDENTIFIER)>;     \
+                                                                                                                       \
+        inline static OriginFuncType OriginalFunc{};                                                                   \
+                                                                                                                       \
+        static FuncPtr resolveTarget() { return glacie::memory::resolveIdentifier<OriginFuncType>(IDENTIFIER); }       \
+                                                                                                                       \
+    public:                                                                                                            \
+        [[nodiscard]] static constexpr char const* getHookName() noexcept { return #DEF_TYPE; }                        \
+                                                                                                                       \
+        template <class... Args>                                                                                       \
+        STATIC RET_TYPE origin(Args&&... params) {                                                                     \
+            if constexpr (Index + 1 == Chain::size) {                                                                  \
+                return CALL(std::forward<Args>(params)...);                                                            \
+            } else {                                                                                                   \
+                using Next = typename Chain::template Layer<Index + 1>;                                                \
+                return NEXT detour(std::forward<Args>(params)...);                                                     \
+            }                                                                                                          \
+        }                                                                                                              \
+                                                                                                                       \
+        STATIC RET_TYPE detour(__VA_ARGS__);                                                                           \
+                                                                                                                       \
+        template <class... Args>                                                                                       \
+        STATIC RET_TYPE dispatch(Args... params) {                                                                     \
+            ::glacie::memory::EpochGuard guard;                                                                        \
+            if (Chain::SuspendCount) [[unlikely]] {                                                                    \
+                using Next = typename Chain::template Layer<Chain::size - 1>;                                          \
+                return NEXT origin(std::forward<Args>(params)...);                                                     \
+            }                                                                                                          \
+            return detour(std::forward<Args>(params)...);                                                              \
+        }                                                                                                              \
+    };                                                                                                                 \
+    template <class Chain, size_t Index>                                                                               \
+    RET_TYPE DEF_TYPE<Chain, Index>::detour(__VA_ARGS__)
+
+#define GLACIE_FUSED_STATIC_HOOK_IMPL(...)                                                                             \
+    VA_EXPAND(GLACIE_FUSED_HOOK_IMPL((*), static, ::glacie::memory::loadOriginalFunc(OriginalFunc), Next::, __VA_ARGS__))
+
+#define GLACIE_FUSED_INSTANCE_HOOK_IMPL(DEF_TYPE, ...)                                                                 \
+    VA_EXPAND(GLACIE_FUSED_HOOK_IMPL(                                                                                  \
+        (DEF_TYPE::*),                                                                                                 \
+        ,                                                                                                              \
+        (this->*::glacie::memory::loadOriginalFunc(OriginalFunc)),                                                     \
+        reinterpret_cast<Next*>(this)->,                                                                               \
+        DEF_TYPE,                                                                                                      \
+        __VA_ARGS__                                                                                                    \
+    ))
 
 /**
  * @brief Register a hook for a typed static function.
@@ -229,4 +485,53 @@ struct Hook {};
  * @see INSTANCE_HOOK for usage.
  */
 #define GLACIE_AUTO_INSTANCE_HOOK(DEF_TYPE, IDENTIFIER, RET_TYPE, ...)                                                 \
-    VA_EXPAND(GLACIE_AUTO_INSTANCE_HOOK_IMPL(DEF_TYPE, ::glacie::memory::Hook, IDENTIFIER, RET_TYPE, __VA_ARGS__))
\ No newline at end of file
+    VA_EXPAND(GLACIE_AUTO_INSTANCE_HOOK_IMPL(DEF_TYPE, ::glacie::memory::Hook, IDENTIFIER, RET_TYPE, __VA_ARGS__))
+
+/**
+ * @brief Define a layer of a fused hook chain for a typed static function.
+ * @details DEF_TYPE is a template which only takes effect as a layer of
+ * GLACIE_FUSED_HOOK_CHAIN. The chain and all of its layers must be defined in the same
+ * translation unit so that the detours can be inlined into each other.
+ * @see TYPE_STATIC_HOOK for the parameters.
+ */
+#define GLACIE_FUSED_TYPE_STATIC_HOOK(DEF_TYPE, TYPE, IDENTIFIER, RET_TYPE, ...)                                       \
+    VA_EXPAND(GLACIE_FUSED_STATIC_HOOK_IMPL(DEF_TYPE, TYPE, IDENTIFIER, RET_TYPE, __VA_ARGS__))
+
+/**
+ * @brief Define a layer of a fused hook chain for a static function.
+ * @see FUSED_TYPE_STATIC_HOOK for usage.
+ */
+#define GLACIE_FUSED_STATIC_HOOK(DEF_TYPE, IDENTIFIER, RET_TYPE, ...)                                                  \
+    VA_EXPAND(GLACIE_FUSED_STATIC_HOOK_IMPL(DEF_TYPE, ::glacie::memory::Hook, IDENTIFIER, RET_TYPE, __VA_ARGS__))
+
+/**
+ * @brief Define a layer of a fused hook chain for a typed instance function.
+ * @see FUSED_TYPE_STATIC_HOOK for usage.
+ */
+#define GLACIE_FUSED_TYPE_INSTANCE_HOOK(DEF_TYPE, TYPE, IDENTIFIER, RET_TYPE, ...)                                     \
+    VA_EXPAND(GLACIE_FUSED_INSTANCE_HOOK_IMPL(DEF_TYPE, TYPE, IDENTIFIER, RET_TYPE, __VA_ARGS__))
+
+/**
+ * @brief Define a layer of a fused hook chain for a instance function.
+ * @see FUSED_TYPE_STATIC_HOOK for usage.
+ */
+#define GLACIE_FUSED_INSTANCE_HOOK(DEF_TYPE, IDENTIFIER, RET_TYPE, ...)                                                \
+    VA_EXPAND(GLACIE_FUSED_INSTANCE_HOOK_IMPL(DEF_TYPE, ::glacie::memory::Hook, IDENTIFIER, RET_TYPE, __VA_ARGS__))
+
+/**
+ * @brief Compose fused hook layers into a single hook.
+ * @param DEF_TYPE The name of the chain.
+ * @param ... The layers, from the outermost to the innermost.
+ *
+ * @note register or unregister by calling DEF_TYPE::hook() and DEF_TYPE::unhook().
+ */
+#define GLACIE_FUSED_HOOK_CHAIN(DEF_TYPE, ...) using DEF_TYPE = ::glacie::memory::FusedHookChain<__VA_ARGS__>
+
+/**
+ * @brief Compose fused hook layers into a single hook.
+ * @details The chain will be automatically registered and unregistered.
+ * @see FUSED_HOOK_CHAIN for usage.
+ */
+#define GLACIE_AUTO_FUSED_HOOK_CHAIN(DEF_TYPE, ...)                                                                    \
+    GLACIE_FUSED_HOOK_CHAIN(DEF_TYPE, __VA_ARGS__);                                                                    \
+    inline ::glacie::memory::HookRegistrar<DEF_TYPE> DEF_TYPE##AutoRegister
@@ -1,25 +1,45 @@
 #pragma once
 
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <functional>
+#include <initializer_list>
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <type_traits>
 #include <vector>
 
 #include "glacie/base/FixedString.h"
+#include "glacie/memory/ResolveCache.h"
 #include "glacie/utils/StringUtils.h"
 #include "libhat/Signature.hpp"
 
+#ifndef _WIN32
+#include <malloc.h>
+#endif
+
 namespace glacie::memory {
 
 using FuncPtr = void*;
 using Handle  = void*;
 
+class PatchBatch;
+
+#ifdef _WIN32
 extern "C" struct _IMAGE_DOS_HEADER __ImageBase; // NOLINT(bugprone-reserved-identifier)
 
+inline constexpr char const* serverModuleName = "bedrock_server.exe";
+#else
+// the ELF header of the current module, defined by the linker
+extern "C" [[gnu::visibility("hidden")]] char const __ehdr_start; // NOLINT(bugprone-reserved-identifier)
+
+// the native server is the main program, which getImageRange finds by an empty name
+inline constexpr char const* serverModuleName = "";
+#endif
+
 template <class T>
     requires(sizeof(T) == sizeof(FuncPtr))
 constexpr FuncPtr toFuncPtr(T t) {
@@ -57,11 +77,99 @@ inline void memcpy_t(void* dst, void const* src) {
 
 /**
  * @brief resolve signature to function pointer
+ * @details A signature found in a registered offset table is not scanned at all. Other results are
+ * memoized in the process-wide resolution table.
  * @param t Signature
  * @return function pointer
  */
 FuncPtr resolveSignature(const char* signature);
 
+/**
+ * @brief resolve signature in a loaded module to function pointer
+ * @param moduleName Name of the module, such as "bedrock_server.exe"
+ * @param signature Signature
+ * @return function pointer
+ */
+FuncPtr resolveSignature(const char* moduleName, const char* signature);
+
+/**
+ * @brief scan the module for a signature without consulting the resolution table
+ * @param t Signature
+ * @return function pointer
+ */
+FuncPtr scanSignature(const char* signature);
+
+FuncPtr scanSignature(const char* moduleName, const char* signature);
+
+/**
+ * @brief scan a range of memory for a signature
+ * @param range Readable memory, such as the image of a module
+ * @param signature Signature
+ * @return function pointer
+ */
+FuncPtr scanSignature(std::span<std::byte const> range, const char* signature);
+
+/**
+ * @brief find every match of a signature in a range in one pass
+ * @details Matches are reported in ascending order and may overlap.
+ * @param range Readable memory, such as the image of a module
+ * @param signature Signature
+ * @param callback Called with each match, returns false to stop the scan
+ * @param limit Maximum number of matches, 0 for no limit
+ * @return number of matches reported
+ */
+size_t findAll(
+    std::span<std::byte const>          range,
+    const char*                         signature,
+    const std::function<bool(FuncPtr)>& callback,
+    size_t                              limit = 0
+);
+
+size_t findAll(
+    const char*                         moduleName,
+    const char*                         signature,
+    const std::function<bool(FuncPtr)>& callback,
+    size_t                              limit = 0
+);
+
+/**
+ * @brief find every match of a signature in the server
+ * @param signature Signature
+ * @param limit Maximum number of matches, 0 for no limit
+ * @return matches in ascending order
+ */
+[[nodiscard]] std::vector<FuncPtr> findAll(const char* signature, size_t limit = 0);
+
+/**
+ * @brief queue a write of bytes at every match of a signature in the server
+ * @details Nothing is written until the batch is committed, so all occurrences are patched in a
+ * single protection cycle. Every match is found in the original bytes, and the writes are applied
+ * in ascending order, so where the writes of overlapping matches overlap the later match wins.
+ * @param batch Batch receiving the writes
+ * @param signature Signature
+ * @param bytes Bytes to write
+ * @param offset Offset of the write from the start of each match
+ * @param limit Maximum number of matches, 0 for no limit
+ * @return number of matches queued
+ */
+size_t patchAll(
+    PatchBatch&              batch,
+    const char*              signature,
+    std::span<uint8_t const> bytes,
+    ptrdiff_t                offset = 0,
+    size_t                   limit  = 0
+);
+
+inline size_t patchAll(
+    PatchBatch&                    batch,
+    const char*                    signature,
+    std::initializer_list<uint8_t> bytes,
+    ptrdiff_t                      offset = 0,
+    size_t                         limit  = 0
+) {
+    return patchAll(batch, signature, std::span<uint8_t const>{bytes.begin(), bytes.size()}, offset, limit);
+}
+
 /**
  * @brief make a region of memory writable and executable, then call the
  * callback, and finally restore the region.
@@ -73,10 +181,15 @@ void modify(void* ptr, size_t len, const std::function<void()>& callback);
 
 Handle getModuleHandle(void* addr);
 
+#ifdef _WIN32
 inline Handle getCurrentModuleHandle() { return &__ImageBase; }
+#else
+inline Handle getCurrentModuleHandle() { return (Handle)&__ehdr_start; }
+#endif
 
-template <class T>
-inline void modify(T& ref, std::function<void(std::remove_cvref_t<T>&)> const& f) {
+template <class T, class F>
+    requires(std::is_invocable_v<F, std::remove_cvref_t<T>&>)
+inline void modify(T& ref, F&& f) {
     modify((void*)std::addressof(ref), sizeof(T), [&] { f((std::remove_cvref_t<T>&)(ref)); });
 }
 
@@ -113,22 +226,39 @@ constexpr auto construct(void* ptr, ptrdiff_t off, Args&&... args) {
     );
 }
 
+[[nodiscard]] inline size_t getAllocationSize(void* ptr) {
+#ifdef _WIN32
+    return _msize(ptr);
+#else
+    return malloc_usable_size(ptr);
+#endif
+}
+
 [[nodiscard]] inline size_t getMemSizeFromPtr(void* ptr) {
     if (!ptr) { return 0; }
-    return _msize(ptr);
+    return getAllocationSize(ptr);
 }
 
 template <class T, class D>
 [[nodiscard]] inline size_t getMemSizeFromPtr(std::unique_ptr<T, D>& ptr) {
     if (!ptr) { return 0; }
-    return _msize(ptr.get());
+    return getAllocationSize(ptr.get());
 }
 
+// the control blocks of MSVC STL and libstdc++ share the layout this relies on
+#ifdef _MSC_VER
 template <template <class> class P, class T>
 [[nodiscard]] inline size_t getMemSizeFromPtr(P<T>& ptr)
     requires(std::derived_from<P<T>, std::_Ptr_base<T>>)
 {
     auto& refc = dAccess<std::_Ref_count_base*>(std::addressof(ptr), 8);
+#else
+template <template <class> class P, class T>
+[[nodiscard]] inline size_t getMemSizeFromPtr(P<T>& ptr)
+    requires(std::same_as<P<T>, std::shared_ptr<T>> || std::same_as<P<T>, std::weak_ptr<T>>)
+{
+    auto& refc = dAccess<void*>(std::addressof(ptr), 8);
+#endif
     if (!refc) { return 0; }
     auto& rawptr = dAccess<T*>(std::addressof(ptr), 0);
     if (!rawptr) { return 0; }
@@ -136,7 +266,7 @@ template <template <class> class P, class T>
         if (rawptr == dAccess<T*>(refc, 8 + 4 * 2)) { return getMemSizeFromPtr(rawptr); }
     }
     // clang-format off
-    return _msize(refc // ptr* 8, rep* 8
+    return getAllocationSize(refc // ptr* 8, rep* 8
     ) - ( // rep:
     8 +                        // vtable
     4 * 2 +                    // uses & weaks
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+namespace glacie::memory {
+
+using FuncPtr = void*;
+
+struct OffsetEntry {
+    char const* signature;
+    uint64_t    rva;
+};
+
+/**
+ * @brief Identify the build of an executable file.
+ * @details The fingerprint of a PE image is made of its TimeDateStamp and SizeOfImage, the one
+ * of an ELF image is a hash of its GNU build id.
+ * @param file Content of the executable file
+ * @return fingerprint, or nullopt if the file has none
+ */
+[[nodiscard]] std::optional<uint64_t> getImageFingerprint(std::span<uint8_t const> file);
+
+[[nodiscard]] std::optional<uint64_t> getServerFingerprint();
+
+/**
+ * @brief Search the executable sections of an executable file for a signature.
+ * @param file Content of the executable file
+ * @return RVA of the first match
+ */
+[[nodiscard]] std::optional<uint64_t> scanImageSignature(std::span<uint8_t const> file, char const* signature);
+
+/**
+ * @brief Use offsets resolved ahead of time for the signatures of the server.
+ * @details The table is only used if the fingerprint matches the running server, so a table
+ * generated for another build is ignored and its signatures are scanned as usual. Nothing
+ * registers the table by itself: call this before any signature is resolved, typically first
+ * thing in the entry of the plugin. signatureCache is initialized with the other globals, so a
+ * signature which it resolves before the table is registered is scanned and keeps that result.
+ * @param entries Entries with static storage duration, as written by GlacieOffsetResolver
+ * @return whether the table matches the server
+ */
+bool registerOffsetTable(uint64_t fingerprint, std::span<OffsetEntry const> entries);
+
+/**
+ * @brief Look up a signature of the server in the registered offset tables.
+ * @return function pointer, or nullptr if the signature is not in a table
+ */
+[[nodiscard]] FuncPtr findOffsetTable(std::string_view signature);
+
+} // namespace glacie::memory
\ No newline at end of file
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
+#include <vector>
+
+#include "glacie/memory/Hook.h"
+
+namespace glacie::memory {
+
+/**
+ * @brief Register a byte patch and save the bytes it replaces.
+ * @param address Address of the patch
+ * @param bytes Patched bytes
+ * @param enable Whether to write the patch immediately
+ * @return id of the patch, or -1 if the region overlaps a registered patch or
+ * could not be written
+ */
+int registerPatch(void* address, std::span<uint8_t const> bytes, bool enable = true);
+
+/**
+ * @brief Register a byte patch at an offset from a resolved identifier.
+ * @param identifier signature or symbol
+ * @param offset Offset from the resolved address
+ * @see registerPatch(void*, std::span<uint8_t const>, bool)
+ */
+int registerPatch(char const* identifier, ptrdiff_t offset, std::span<uint8_t const> bytes, bool enable = true);
+
+/**
+ * @brief Restore the original bytes if needed and forget the patch.
+ */
+bool removePatch(int id);
+
+/**
+ * @brief Enable or disable several patches in a single batched write.
+ * @return false if an id is unknown or the memory could not be written, in which
+ * case no patch is changed
+ */
+bool setPatchesEnabled(std::span<int const> ids, bool enable);
+
+inline bool enablePatch(int id) { return setPatchesEnabled(std::span<int const>{&id, 1}, true); }
+
+inline bool disablePatch(int id) { return setPatchesEnabled(std::span<int const>{&id, 1}, false); }
+
+[[nodiscard]] bool isPatchEnabled(int id);
+
+/**
+ * @brief A set of patches that are toggled together, e.g. one feature.
+ * @details Every patch of the group is removed when the group is destroyed.
+ *
+ * @par Example
+ * @code
+ * PatchGroup group;
+ * group.add("48 8B ?? ?? 74 ??", 3, {0xEB}); // turn je into jmp
+ * group.disable();
+ * @endcode
+ */
+class PatchGroup {
+public:
+    PatchGroup() = default;
+    ~PatchGroup() { clear(); }
+
+    PatchGroup(PatchGroup const&)            = delete;
+    PatchGroup& operator=(PatchGroup const&) = delete;
+    PatchGroup(PatchGroup&& other) noexcept : ids(std::move(other.ids)) { other.ids.clear(); }
+    PatchGroup& operator=(PatchGroup&& other) noexcept {
+        if (this != &other) {
+            clear();
+            ids = std::move(other.ids);
+            other.ids.clear();
+        }
+        return *this;
+    }
+
+    bool add(void* address, std::span<uint8_t const> bytes, bool enable = true) {
+        return push(registerPatch(address, bytes, enable));
+    }
+
+    bool add(void* address, std::initializer_list<uint8_t> bytes, bool enable = true) {
+        return add(address, std::span<uint8_t const>{bytes.begin(), bytes.size()}, enable);
+    }
+
+    bool add(char const* identifier, ptrdiff_t offset, std::span<uint8_t const> bytes, bool enable = true) {
+        return push(registerPatch(identifier, offset, bytes, enable));
+    }
+
+    bool add(char const* identifier, ptrdiff_t offset, std::initializer_list<uint8_t> bytes, bool enable = true) {
+        return add(identifier, offset, std::span<uint8_t const>{bytes.begin(), bytes.size()}, enable);
+    }
+
+    bool enable() { return setPatchesEnabled(ids, true); }
+
+    bool disable() { return setPatchesEnabled(ids, false); }
+
+    void clear() {
+        for (auto id : ids) removePatch(id);
+        ids.clear();
+    }
+
+    [[nodiscard]] std::span<int const> getIds() const noexcept { return ids; }
+
+private:
+    std::vector<int> ids;
+
+    bool push(int id) {
+        if (id < 0) { return false; }
+        ids.push_back(id);
+        return true;
+    }
+};
+
+} // namespace glacie::memory
\ No newline at end of file
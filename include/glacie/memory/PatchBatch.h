@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "glacie/memory/Timeline.h"
+
+namespace glacie::memory {
+
+/**
+ * @brief Collect writes to protected memory and apply them in one protection cycle.
+ * @details Touched pages are coalesced, made writable once, all writes are applied,
+ * the original protection is restored and the instruction cache is flushed once.
+ *
+ * @par Example
+ * @code
+ * PatchBatch batch;
+ * batch.fill(checkAddr, 0x90, 6);             // nop out a check
+ * batch.add(flagAddr, {0xB0, 0x01, 0xC3});    // mov al, 1; ret
+ * batch.commit();
+ * @endcode
+ */
+class PatchBatch {
+public:
+    PatchBatch() = default;
+
+    /**
+     * @brief Queue a write of bytes to address.
+     * @param address Destination
+     * @param bytes Bytes to write, copied into the batch
+     */
+    PatchBatch& add(void* address, std::span<uint8_t const> bytes);
+
+    PatchBatch& add(void* address, std::initializer_list<uint8_t> bytes) {
+        return add(address, std::span<uint8_t const>{bytes.begin(), bytes.size()});
+    }
+
+    template <class T>
+        requires(std::is_trivially_copyable_v<T>)
+    PatchBatch& add(T& ref, T const& value) {
+        return add(
+            (void*)std::addressof(ref),
+            std::span<uint8_t const>{reinterpret_cast<uint8_t const*>(std::addressof(value)), sizeof(T)}
+        );
+    }
+
+    /**
+     * @brief Queue a write of count copies of value to address, e.g. a nop sled.
+     */
+    PatchBatch& fill(void* address, uint8_t value, size_t count);
+
+    /**
+     * @brief Make a region writable during commit without queueing a write.
+     * @details The region can be written by the callback passed to commit.
+     */
+    PatchBatch& touch(void* address, size_t len);
+
+    /**
+     * @brief Apply all queued writes, then call the callback while the pages are
+     * still writable.
+     * @return false if the protection of a page could not be changed, in which
+     * case nothing is written
+     */
+    template <class F>
+    bool commit(F&& callback) {
+        TimelineScope timeline(TimelineEventKind::PatchCommit, "PatchBatch");
+        timeline.addBytes(data.size());
+        if (!unprotect()) { return false; }
+        applyWrites();
+        std::forward<F>(callback)();
+        restore();
+        return true;
+    }
+
+    bool commit() {
+        return commit([] {});
+    }
+
+    void clear();
+
+    [[nodiscard]] bool empty() const noexcept { return ranges.empty(); }
+
+    [[nodiscard]] size_t size() const noexcept { return writes.size(); }
+
+private:
+    struct Write {
+        uint8_t* address{};
+        size_t   offset{};
+        size_t   size{};
+    };
+
+    struct Range {
+        uintptr_t begin{};
+        uintptr_t end{};
+    };
+
+    struct Region {
+        uintptr_t begin{};
+        size_t    size{};
+        uint32_t  protect{};
+    };
+
+    std::vector<Write>   writes;
+    std::vector<uint8_t> data;
+    std::vector<Range>   ranges;
+    std::vector<Region>  regions;
+
+    bool unprotect();
+    void applyWrites();
+    void restore();
+};
+
+} // namespace glacie::memory
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "glacie/memory/Hook.h"
+
+namespace glacie::memory {
+
+struct ProbeStats {
+    int         id{};
+    std::string name{};
+    FuncPtr     target{};
+    uint64_t    calls{};
+    uint64_t    totalTicks{};
+    uint64_t    minTicks{};
+    uint64_t    maxTicks{};
+};
+
+/**
+ * @brief Attach a profiling probe to a function without a typed hook definition.
+ * @details The probe preserves the argument registers, including al of variadic calls on
+ * Linux, and only clobbers the scratch register r11. It records the time between entry and
+ * return into per-thread aggregates and then continues into the function. The return
+ * address is redirected while the function runs, so do not probe functions which are left
+ * through exceptions or longjmp.
+ * @note The entry stub of a removed probe is kept, and the function gets the same id when it
+ * is probed again. Ids are never shared between functions, so at most 4096 functions can be
+ * probed during the lifetime of the process.
+ * @param target Address of the function
+ * @param name Name shown in the statistics
+ * @return id of the probe, or -1 on failure
+ */
+int addProbe(FuncPtr target, std::string_view name);
+
+/**
+ * @brief Attach a profiling probe to a function given by signature or symbol.
+ */
+int addProbe(char const* identifier);
+
+/**
+ * @brief Attach a profiling probe to every identifier.
+ * @return the id of each probe, -1 for those that failed
+ */
+std::vector<int> addProbes(std::span<char const* const> identifiers);
+
+bool removeProbe(int id);
+
+void removeAllProbes();
+
+/**
+ * @brief Sum up the aggregates of all threads for every attached probe.
+ * @note Ticks are in TSC units.
+ */
+[[nodiscard]] std::vector<ProbeStats> getProbeStats();
+
+void resetProbeStats();
+
+} // namespace glacie::memory
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace glacie::memory {
+
+using FuncPtr = void*;
+
+struct ResolveCacheStats {
+    size_t hits{};
+    size_t misses{};
+    size_t entries{};
+};
+
+[[nodiscard]] constexpr uint64_t hashIdentifier(std::string_view str, uint64_t seed = 0xcbf29ce484222325) noexcept {
+    for (char c : str) {
+        seed ^= static_cast<uint8_t>(c);
+        seed *= 0x100000001b3;
+    }
+    return seed;
+}
+
+/**
+ * @brief Get the spelling of a module name used as key, which is lower case on Windows where module
+ * names are case-insensitive.
+ */
+[[nodiscard]] std::string normalizeModuleName(std::string_view name);
+
+/**
+ * @brief Look up an identifier in the process-wide resolution table.
+ * @details Module names are compared as normalizeModuleName does.
+ * @param module Name of the module the identifier belongs to
+ * @param identifier signature or symbol
+ * @param result The cached address, nullptr for a cached failure
+ * @return whether the identifier is cached
+ */
+[[nodiscard]] bool findResolveCache(std::string_view module, std::string_view identifier, FuncPtr& result);
+
+void insertResolveCache(std::string_view module, std::string_view identifier, FuncPtr result);
+
+/**
+ * @brief Resolve an identifier once per process and module.
+ * @details Failed resolutions are cached too, so a missing signature is only scanned once.
+ * @param resolver Called on a miss and returns the address or nullptr
+ */
+template <class F>
+FuncPtr resolveCached(std::string_view module, std::string_view identifier, F&& resolver) {
+    FuncPtr result;
+    if (findResolveCache(module, identifier, result)) { return result; }
+    result = std::forward<F>(resolver)();
+    insertResolveCache(module, identifier, result);
+    return result;
+}
+
+[[nodiscard]] ResolveCacheStats getResolveCacheStats();
+
+/**
+ * @brief Drop the cached identifiers of a module, such as when it has been unloaded.
+ */
+void eraseResolveCache(std::string_view module);
+
+void clearResolveCache();
+
+} // namespace glacie::memory
\ No newline at end of file
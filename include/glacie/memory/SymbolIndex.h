@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "glacie/utils/FileUtils.h"
+
+namespace glacie::memory {
+
+using FuncPtr = void*;
+
+struct SymbolEntry {
+    std::string name{};
+    uint64_t    rva{};
+};
+
+/**
+ * @brief A hashed index from symbol names to RVAs.
+ * @details The index is a flat open-addressing hash table followed by the names, so it can
+ * be memory-mapped and searched in O(1) without being parsed.
+ */
+class SymbolIndex {
+public:
+    SymbolIndex() = default;
+
+    /**
+     * @brief Serialize entries into an index. Duplicated names keep the first entry.
+     */
+    [[nodiscard]] static std::vector<uint8_t> build(std::span<SymbolEntry const> entries);
+
+    /**
+     * @brief Read the public symbols of a MSVC linker map file.
+     */
+    [[nodiscard]] static std::vector<SymbolEntry> readMapFile(std::string const& path);
+
+    /**
+     * @brief Read the defined symbols of .symtab and .dynsym of an ELF64 image.
+     * @details The RVA of a symbol is relative to the load bias of the image.
+     */
+    [[nodiscard]] static std::vector<SymbolEntry> readElfSymbols(std::string const& path);
+
+    /**
+     * @brief Memory-map an index written by build().
+     */
+    bool open(std::string const& path);
+
+    /**
+     * @brief Use an index built in memory.
+     */
+    bool load(std::vector<uint8_t> index);
+
+    void close();
+
+    [[nodiscard]] bool isOpen() const noexcept { return !view.empty(); }
+
+    [[nodiscard]] size_t size() const noexcept;
+
+    [[nodiscard]] std::optional<uint64_t> find(std::string_view name) const;
+
+private:
+    utils::file_utils::MappedFile file;
+    std::vector<uint8_t>          owned;
+    std::span<uint8_t const>      view;
+
+    bool attach(std::span<uint8_t const> data);
+};
+
+/**
+ * @brief Check whether an identifier is a symbol rather than a byte signature.
+ */
+[[nodiscard]] bool isSymbolIdentifier(std::string_view identifier);
+
+/**
+ * @brief Get the path of the server executable.
+ */
+[[nodiscard]] std::filesystem::path getServerPath();
+
+/**
+ * @brief Get the address which the RVAs of the server module are relative to.
+ */
+[[nodiscard]] std::optional<uintptr_t> getServerBase();
+
+/**
+ * @brief Replace the symbol index of the server module with an index file.
+ */
+bool loadSymbolIndex(std::string const& path);
+
+/**
+ * @brief resolve symbol to function pointer
+ * @details Without an explicitly loaded index, an index is built once from the linker map file
+ * of the server (or, on Linux, its ELF symbol tables) and reused afterwards. It is written next
+ * to the server, or into the cache directory of the user if the server directory is read-only.
+ * @param symbol Mangled symbol
+ * @return function pointer
+ */
+FuncPtr resolveSymbol(char const* symbol);
+
+} // namespace glacie::memory
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace glacie::memory {
+
+using FuncPtr = void*;
+
+enum class TimelineEventKind : uint8_t {
+    ResolveSignature,
+    ResolveIdentifier,
+    Hook,
+    ProcessHook,
+    HookRegistrar,
+    PatchCommit,
+};
+
+inline constexpr size_t timelineEventKindCount = 6;
+
+[[nodiscard]] std::string_view getTimelineEventKindName(TimelineEventKind kind) noexcept;
+
+struct TimelineEvent {
+    TimelineEventKind kind{};
+    bool              cacheHit{};
+    uint32_t          threadId{};
+    uint64_t          startNs{}; // since the first use of the timeline
+    uint64_t          durationNs{};
+    uint64_t          bytes{}; // scanned by a signature search, or written by a patch
+    std::string       name{};  // signature, identifier, hook or target address
+};
+
+struct TimelineSummary {
+    TimelineEventKind kind{};
+    size_t            count{};
+    size_t            cacheHits{};
+    uint64_t          totalNs{};
+    uint64_t          maxNs{};
+    uint64_t          bytes{};
+};
+
+/**
+ * @brief Start recording the time spent resolving identifiers and installing hooks.
+ * @details Recording is off by default. Setting the environment variable GLACIE_TIMELINE to 1
+ * starts it before the first event, which covers hooks registered by static initializers.
+ */
+void startTimeline();
+
+void stopTimeline();
+
+[[nodiscard]] bool isTimelineActive() noexcept;
+
+void clearTimeline();
+
+[[nodiscard]] std::vector<TimelineEvent> getTimelineEvents();
+
+/**
+ * @brief Get the longest events of a kind.
+ * @param count Maximum number of events, the longest first
+ */
+[[nodiscard]] std::vector<TimelineEvent> getSlowestTimelineEvents(TimelineEventKind kind, size_t count);
+
+/**
+ * @brief Get the totals of every kind that has events.
+ */
+[[nodiscard]] std::vector<TimelineSummary> getTimelineSummary();
+
+/**
+ * @brief Write the events in the Chrome trace event JSON format.
+ */
+bool writeTimelineChromeTrace(std::string const& path);
+
+/**
+ * @brief Write the totals of every kind and its slowest events as JSON.
+ * @param slowestCount Number of slowest events listed for each kind
+ */
+bool writeTimelineSummary(std::string const& path, size_t slowestCount = 20);
+
+/**
+ * @brief Time a step of resolution or hook installation while the timeline is recording.
+ * @details A scope opened inside another scope of the same kind on the same thread is not
+ * recorded, so the outer call accounts for the whole step.
+ */
+class TimelineScope {
+public:
+    TimelineScope(TimelineEventKind kind, std::string_view name);
+    TimelineScope(TimelineEventKind kind, FuncPtr address);
+    ~TimelineScope();
+
+    TimelineScope(TimelineScope const&)            = delete;
+    TimelineScope& operator=(TimelineScope const&) = delete;
+
+    void setCacheHit(bool hit) noexcept { owner->cacheHit = hit; }
+
+    void addBytes(uint64_t count) noexcept { owner->bytes += count; }
+
+    [[nodiscard]] explicit operator bool() const noexcept { return active; }
+
+private:
+    TimelineScope*    parent{};
+    TimelineScope*    owner{this}; // the enclosing scope of the same kind if this one is not recorded
+    TimelineEventKind kind;
+    bool              active{};
+    bool              cacheHit{};
+    uint64_t          startNs{};
+    uint64_t          bytes{};
+    std::string       name{};
+
+    void open();
+};
+
+/**
+ * @brief Add to the bytes of the innermost recording scope of the current thread.
+ */
+void addTimelineBytes(uint64_t count) noexcept;
+
+} // namespace glacie::memory
\ No newline at end of file
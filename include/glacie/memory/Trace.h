@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+namespace glacie::memory {
+
+#ifdef GLACIE_HOOK_TRACE
+inline constexpr bool hookTraceEnabled = true;
+#else
+inline constexpr bool hookTraceEnabled = false;
+#endif
+
+struct TraceFileHeader {
+    char     magic[8];
+    uint64_t ticksPerSecond;
+    uint64_t startTicks;
+    uint64_t recordCount;
+    uint64_t droppedCount;
+    uint64_t namesOffset; // uint32_t count, then uint32_t id, uint32_t size and the name for each source
+};
+
+struct TraceRecord {
+    uint64_t ticks;
+    uint32_t source; // the highest bit is set for exit records
+    uint32_t threadId;
+};
+
+inline constexpr uint32_t TRACE_EXIT_FLAG = 0x80000000;
+
+struct TraceRing {
+    static constexpr size_t capacity = 1 << 14;
+
+    alignas(64) std::atomic_uint64_t head{};
+    alignas(64) std::atomic_uint64_t tail{};
+    std::atomic_uint64_t dropped{};
+    std::atomic_bool     inUse{};
+    uint32_t             threadId{};
+    TraceRecord          records[capacity]{};
+};
+
+inline std::atomic_bool hookTraceActive{};
+
+inline thread_local TraceRing* currentTraceRing{};
+
+TraceRing& registerTraceThread();
+
+/**
+ * @brief Append a record to the single-producer ring of the current thread.
+ * @details Records are dropped instead of blocking when the drainer falls behind.
+ */
+inline void writeTraceRecord(uint32_t source) noexcept {
+    auto ring = currentTraceRing;
+    if (!ring) [[unlikely]] { ring = &registerTraceThread(); }
+    auto head = ring->head.load(std::memory_order_relaxed);
+    if (head - ring->tail.load(std::memory_order_acquire) >= TraceRing::capacity) [[unlikely]] {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    ring->records[head & (TraceRing::capacity - 1)] = {__rdtsc(), source, ring->threadId};
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Record the enter and exit of a hook while tracing is running.
+ */
+template <bool Enabled>
+class HookTraceScope {
+public:
+    explicit HookTraceScope(uint32_t) noexcept {}
+};
+
+template <>
+class HookTraceScope<true> {
+public:
+    explicit HookTraceScope(uint32_t source) noexcept
+    : source(hookTraceActive.load(std::memory_order_relaxed) ? source : 0) {
+        if (this->source) { writeTraceRecord(this->source); }
+    }
+    ~HookTraceScope() noexcept {
+        if (source) { writeTraceRecord(source | TRACE_EXIT_FLAG); }
+    }
+
+    HookTraceScope(HookTraceScope const&)            = delete;
+    HookTraceScope& operator=(HookTraceScope const&) = delete;
+
+private:
+    uint32_t source;
+};
+
+/**
+ * @brief Get the id of a named trace source, registering it on first use.
+ */
+uint32_t registerTraceSource(std::string_view name);
+
+/**
+ * @brief Start streaming hook records into a memory-mapped binary file.
+ * @details Only hooks compiled with GLACIE_HOOK_TRACE defined produce records.
+ * @return false if tracing is already running or the file cannot be created
+ */
+bool startHookTrace(std::string const& path);
+
+/**
+ * @brief Drain the remaining records and finish the trace file.
+ * @return false if tracing is not running or the trace file could not be written completely
+ */
+bool stopHookTrace();
+
+/**
+ * @brief Convert a binary trace file into the Chrome trace event JSON format.
+ */
+bool convertTraceToChromeJson(std::string const& tracePath, std::string const& jsonPath);
+
+} // namespace glacie::memory
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace glacie::memory {
+
+using FuncPtr = void*;
+
+/**
+ * @brief Get the length of the x86-64 instruction at code.
+ * @details Only the general purpose, x87, SSE and VEX encoded instructions are known, which
+ * covers what compilers emit in function prologues.
+ * @return length in bytes, or 0 if the instruction is not known
+ */
+[[nodiscard]] size_t getInstructionLength(void const* code);
+
+/**
+ * @brief Redirect target to detour by overwriting its first instruction with a jump.
+ * @details The overwritten instructions are relocated into a trampoline allocated within
+ * 2GB of target, so a rel32 jump reaches it. Other threads are never suspended. If the first
+ * instruction is at least 5 bytes long, the jump replaces it with a single atomic store of the
+ * aligned 8 or 16 bytes around it. Otherwise, if 5 bytes of padding precede target, the jump
+ * is written into the padding and a 2 byte jump to it replaces the first instruction atomically.
+ * A target which was attached before reuses its trampoline as long as its code is unchanged.
+ * @param originalFunc Receives the trampoline, which runs the overwritten instructions and
+ * continues in target
+ * @param live Fail instead of writing the jump non-atomically when neither applies, which is
+ * only safe while no other thread runs target
+ * @return 0 on success
+ */
+int attachTrampoline(FuncPtr target, FuncPtr detour, FuncPtr* originalFunc, bool live = false);
+
+/**
+ * @brief Restore the instructions overwritten by attachTrampoline.
+ * @details The instructions are restored the same way the jump was written. A thread may have
+ * fetched the jump right before, and it takes no epoch guard before it reaches the detour, so the
+ * padding jump and the trampoline are never released. The trampoline is redirected to run the
+ * original instructions instead of the detour, and is reused when target is attached again.
+ * @param originalFunc The trampoline received from attachTrampoline
+ * @return 0 on success, -1 if originalFunc is not a trampoline or cannot be restored
+ */
+int detachTrampoline(FuncPtr* originalFunc);
+
+/**
+ * @brief Forget a trampoline whose target is about to be unmapped, without writing to it.
+ * @details The trampoline is never released, since a thread may still be inside it.
+ * @return 0 on success, -1 if originalFunc is not a trampoline
+ */
+int discardTrampoline(FuncPtr* originalFunc);
+
+} // namespace glacie::memory
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace glacie::utils::file_utils {
+
+/**
+ * @brief A read-only memory mapping of a whole file.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    explicit MappedFile(std::string const& path) { open(path); }
+    ~MappedFile() { close(); }
+
+    MappedFile(MappedFile const&)            = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(std::string const& path);
+
+    void close();
+
+    [[nodiscard]] bool isOpen() const noexcept { return data != nullptr; }
+
+    [[nodiscard]] std::span<uint8_t const> getData() const noexcept { return {data, size}; }
+
+private:
+    uint8_t const* data{};
+    size_t         size{};
+#ifdef _WIN32
+    void* mapping{};
+#endif
+};
+
+bool writeFile(std::string const& path, std::span<uint8_t const> data);
+
+} // namespace glacie::utils::file_utils
\ No newline at end of file
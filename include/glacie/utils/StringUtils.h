@@ -1,7 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 
 #include "glacie/memory/Memory.h"
@@ -28,6 +34,40 @@ splitByPattern(std::string_view s, std::string_view pattern, bool keepEmpty = fa
     return ret;
 }
 
+/**
+ * @brief Replace all founded sub std::string and return the result
+ * @details The result is built in a single pass, so the time is linear in the size of the input
+ * even if the lengths of the values differ. An empty oldValue matches nothing.
+ * @param str       The input std::string
+ * @param oldValue  The sub string to be replaced
+ * @param newValue  The string to replace with
+ * @return std::string  The new std::string
+ */
+[[nodiscard]] constexpr std::string
+replaceAll(std::string_view str, std::string_view oldValue, std::string_view newValue) {
+    if (oldValue.empty()) return std::string{str};
+    size_t pos = str.find(oldValue);
+    if (pos == std::string_view::npos) return std::string{str};
+
+    size_t size = str.size();
+    if (newValue.size() > oldValue.size()) {
+        // count the matches first so the result is allocated once
+        for (size_t p = pos; p != std::string_view::npos; p = str.find(oldValue, p + oldValue.size())) {
+            size += newValue.size() - oldValue.size();
+        }
+    }
+    std::string ret;
+    ret.reserve(size);
+    size_t last = 0;
+    for (; pos != std::string_view::npos; pos = str.find(oldValue, last)) {
+        ret.append(str.substr(last, pos - last));
+        ret.append(newValue);
+        last = pos + oldValue.size();
+    }
+    ret.append(str.substr(last));
+    return ret;
+}
+
 /**
  * @brief Replace all founded sub std::string and modify input str
  * @param str       The input std::string
@@ -36,18 +76,89 @@ splitByPattern(std::string_view s, std::string_view pattern, bool keepEmpty = fa
  * @return std::string  The modified input std::string
  */
 constexpr std::string& replaceAll(std::string& str, std::string_view oldValue, std::string_view newValue) {
-    for (std::string::size_type pos(0); pos != std::string::npos; pos += newValue.length()) {
-        if ((pos = str.find(oldValue, pos)) != std::string::npos) str.replace(pos, oldValue.length(), newValue);
-        else break;
+    if (oldValue.empty()) return str;
+    if (oldValue.size() == newValue.size()) {
+        // nothing moves, so the matches are overwritten in place
+        for (size_t pos = str.find(oldValue); pos != std::string::npos; pos = str.find(oldValue, pos)) {
+            std::copy(newValue.begin(), newValue.end(), str.begin() + (ptrdiff_t)pos);
+            pos += newValue.size();
+        }
+        return str;
     }
+    str = replaceAll(std::string_view{str}, oldValue, newValue);
     return str;
 }
 
-[[nodiscard]] constexpr std::string
-replaceAll(std::string const& str, std::string_view oldValue, std::string_view newValue) {
-    std::string ret = str;
-    replaceAll(ret, oldValue, newValue);
-    return ret;
+/**
+ * @brief Replace a table of sub strings in one scan of the input.
+ * @details The patterns are bucketed by their first byte, so bytes which start no pattern are
+ * skipped with one table lookup. At each position the longest matching pattern is replaced and
+ * the scan continues after it, so a replacement is never matched again. Empty patterns are ignored,
+ * and of patterns given more than once the first entry of the table wins.
+ *
+ * @par Example
+ * @code
+ * MultiReplacer sanitizer{{"&", "&amp;"}, {"<", "&lt;"}, {">", "&gt;"}};
+ * sanitizer("<b>"); // "&lt;b&gt;"
+ * @endcode
+ */
+class MultiReplacer {
+public:
+    MultiReplacer(std::initializer_list<std::pair<std::string_view, std::string_view>> table)
+    : MultiReplacer(std::span{table.begin(), table.size()}) {}
+
+    explicit MultiReplacer(std::span<std::pair<std::string_view, std::string_view> const> table) {
+        for (auto& [oldValue, newValue] : table) {
+            if (!oldValue.empty()) entries.emplace_back(oldValue, newValue);
+        }
+        // group by first byte, longest first within a group, equal patterns keep the order of the table
+        std::stable_sort(entries.begin(), entries.end(), [](auto const& a, auto const& b) {
+            if (a.first[0] != b.first[0]) return (uint8_t)a.first[0] < (uint8_t)b.first[0];
+            return a.first.size() > b.first.size();
+        });
+        size_t index = 0;
+        for (size_t byte = 0; byte < 256; ++byte) {
+            buckets[byte] = (uint32_t)index;
+            while (index < entries.size() && (uint8_t)entries[index].first[0] == byte) ++index;
+        }
+        buckets[256] = (uint32_t)entries.size();
+    }
+
+    [[nodiscard]] std::string operator()(std::string_view str) const {
+        std::string ret;
+        ret.reserve(str.size());
+        size_t last = 0;
+        for (size_t pos = 0; pos < str.size();) {
+            auto byte  = (uint8_t)str[pos];
+            auto end   = entries.begin() + buckets[byte + 1];
+            auto match = std::find_if(entries.begin() + buckets[byte], end, [&](auto const& entry) {
+                return str.substr(pos).starts_with(entry.first);
+            });
+            if (match == end) {
+                ++pos;
+                continue;
+            }
+            ret.append(str.substr(last, pos - last));
+            ret.append(match->second);
+            pos  += match->first.size();
+            last  = pos;
+        }
+        ret.append(str.substr(last));
+        return ret;
+    }
+
+private:
+    std::vector<std::pair<std::string, std::string>> entries;
+    std::array<uint32_t, 257>                        buckets{};
+};
+
+/**
+ * @brief Replace a table of sub strings in one scan of the input.
+ * @details Build a MultiReplacer once instead if the same table is used repeatedly.
+ */
+[[nodiscard]] inline std::string
+replaceAll(std::string_view str, std::span<std::pair<std::string_view, std::string_view> const> table) {
+    return MultiReplacer{table}(str);
 }
 
 constexpr inline uint8_t digitFromByte[] = {
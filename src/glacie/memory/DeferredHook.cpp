@@ -0,0 +1,360 @@
+#include "glacie/memory/DeferredHook.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "glacie/memory/Memory.h"
+#include "glacie/memory/ResolveCache.h"
+
+#ifdef _WIN32
+#include "glacie/utils/StringUtils.h"
+
+#include "windows.h"
+#include <winternl.h>
+#else
+#include <dlfcn.h>
+#include <link.h>
+#endif
+
+namespace glacie::memory {
+
+namespace {
+
+#ifdef _WIN32
+constexpr ULONG LDR_DLL_NOTIFICATION_REASON_LOADED   = 1;
+constexpr ULONG LDR_DLL_NOTIFICATION_REASON_UNLOADED = 2;
+
+struct LdrDllNotificationData {
+    ULONG            flags;
+    PCUNICODE_STRING fullDllName;
+    PCUNICODE_STRING baseDllName;
+    PVOID            dllBase;
+    ULONG            sizeOfImage;
+};
+
+using LdrDllNotificationFunction = VOID(CALLBACK*)(ULONG reason, LdrDllNotificationData const* data, PVOID context);
+using LdrRegisterDllNotificationFunction =
+    NTSTATUS(NTAPI*)(ULONG flags, LdrDllNotificationFunction callback, PVOID context, PVOID* cookie);
+#else
+constexpr auto DEFERRED_HOOK_POLL_DELAY = std::chrono::milliseconds(10);
+#endif
+
+struct DeferredHookData {
+    std::string moduleName{};
+    std::string signature{};
+    FuncPtr     detour{};
+    FuncPtr*    originalFunc{};
+    FuncPtr     target{}; // set while the hook is installed
+};
+
+struct LoadedModule {
+    std::string                moduleName{};
+    std::span<std::byte const> image{};
+};
+
+} // namespace
+
+struct DeferredHookState {
+    std::mutex                                mutex;
+    std::condition_variable                   cv;
+    std::unordered_map<int, DeferredHookData> hooks;
+    std::deque<LoadedModule>                  loaded;
+    bool                                      started{};
+    int                                       lastId{};
+#ifdef _WIN32
+    PVOID cookie{};
+#else
+    unsigned long long loadCount{};
+#endif
+};
+
+DeferredHookState& getDeferredHookState() {
+    // never destroyed, the worker and the loader callback outlive static destruction
+    static auto& state = *new DeferredHookState;
+    return state;
+}
+
+static bool hasPendingHooks(DeferredHookState& state, std::string_view moduleName) {
+    return std::any_of(state.hooks.begin(), state.hooks.end(), [&](auto const& item) {
+        return !item.second.target && (moduleName.empty() || item.second.moduleName == moduleName);
+    });
+}
+
+#ifdef _WIN32
+static std::optional<std::span<std::byte const>> findModuleImage(std::string const& moduleName) {
+    auto module = GetModuleHandleW(utils::string_utils::str2wstr(moduleName).c_str());
+    if (!module) { return std::nullopt; }
+    auto dosHeader = (PIMAGE_DOS_HEADER)module;
+    auto ntHeaders = (PIMAGE_NT_HEADERS)((uintptr_t)module + dosHeader->e_lfanew);
+    return std::span{(std::byte const*)module, ntHeaders->OptionalHeader.SizeOfImage};
+}
+#else
+struct ModuleSearch {
+    std::string_view           moduleName;
+    std::span<std::byte const> image;
+};
+
+// the executable segments of a shared object, which is where signatures are searched
+static std::span<std::byte const> getModuleImage(dl_phdr_info const* info) {
+    uintptr_t begin = UINTPTR_MAX, end = 0;
+    for (int i = 0; i < info->dlpi_phnum; ++i) {
+        auto& header = info->dlpi_phdr[i];
+        if (header.p_type != PT_LOAD || !(header.p_flags & PF_X)) { continue; }
+        begin = std::min<uintptr_t>(begin, info->dlpi_addr + header.p_vaddr);
+        end   = std::max<uintptr_t>(end, info->dlpi_addr + header.p_vaddr + header.p_memsz);
+    }
+    if (begin >= end) { return {}; }
+    return {(std::byte const*)begin, end - begin};
+}
+
+static std::string_view getModuleFileName(dl_phdr_info const* info) {
+    std::string_view path = info->dlpi_name ? info->dlpi_name : "";
+    auto             pos  = path.find_last_of('/');
+    return pos == std::string_view::npos ? path : path.substr(pos + 1);
+}
+
+static std::optional<std::span<std::byte const>> findModuleImage(std::string const& moduleName) {
+    ModuleSearch search{moduleName, {}};
+    dl_iterate_phdr(
+        [](dl_phdr_info* info, size_t, void* data) {
+            auto& search = *(ModuleSearch*)data;
+            if (getModuleFileName(info) != search.moduleName) { return 0; }
+            search.image = getModuleImage(info);
+            return 1;
+        },
+        &search
+    );
+    if (search.image.empty()) { return std::nullopt; }
+    return search.image;
+}
+
+struct PendingModuleSearch {
+    DeferredHookState&        state;
+    std::deque<LoadedModule>& modules;
+};
+
+// append every loaded module with pending hooks to modules
+static void findPendingModules(DeferredHookState& state, std::deque<LoadedModule>& modules) {
+    PendingModuleSearch search{state, modules};
+    dl_iterate_phdr(
+        [](dl_phdr_info* info, size_t, void* data) {
+            auto& search = *(PendingModuleSearch*)data;
+            auto  name   = getModuleFileName(info);
+            if (!name.empty() && hasPendingHooks(search.state, name)) {
+                search.modules.push_back({std::string{name}, getModuleImage(info)});
+            }
+            return 0;
+        },
+        &search
+    );
+}
+
+// queue every loaded module with pending hooks, the objects are only walked again after a load
+static void collectLoadedModules(DeferredHookState& state) {
+    unsigned long long loadCount = 0;
+    dl_iterate_phdr(
+        [](dl_phdr_info* info, size_t, void* data) {
+            *(unsigned long long*)data = info->dlpi_adds;
+            return 1;
+        },
+        &loadCount
+    );
+    if (loadCount == state.loadCount) { return; }
+    state.loadCount = loadCount;
+    findPendingModules(state, state.loaded);
+}
+#endif
+
+static void
+installDeferredHooks(DeferredHookState& state, std::unique_lock<std::mutex>& lock, LoadedModule const& module) {
+    std::vector<std::pair<int, std::string>> pending;
+    for (auto& [id, data] : state.hooks) {
+        if (!data.target && data.moduleName == module.moduleName) { pending.emplace_back(id, data.signature); }
+    }
+    if (pending.empty() || module.image.empty()) { return; }
+
+    // scan without the lock, which the unload callback takes under the loader lock
+    lock.unlock();
+#ifdef _WIN32
+    // the module stays loaded until it is scanned and hooked, so the unload callback never waits for the worker
+    HMODULE handle{};
+    auto    base = (LPCWSTR)module.image.data();
+    if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, base, &handle) || (LPCWSTR)handle != base) {
+        if (handle) { FreeLibrary(handle); }
+        lock.lock();
+        return;
+    }
+#endif
+    std::vector<FuncPtr> targets;
+    targets.reserve(pending.size());
+    for (auto& [id, signature] : pending) targets.push_back(scanSignature(module.image, signature.c_str()));
+    lock.lock();
+
+    for (size_t i = 0; i < pending.size(); ++i) {
+        auto it = state.hooks.find(pending[i].first);
+        if (it == state.hooks.end() || it->second.target || !targets[i]) { continue; }
+        if (hook(targets[i], it->second.detour, it->second.originalFunc) == 0) { it->second.target = targets[i]; }
+    }
+#ifdef _WIN32
+    // the last reference unloads the module on this thread, and the unload callback takes the lock
+    lock.unlock();
+    FreeLibrary(handle);
+    lock.lock();
+#endif
+}
+
+#ifndef _WIN32
+// called on the thread which opened a module, the worker may be installing the same hooks, which is harmless
+// since a hook is only installed by whoever finds it pending under the lock
+static void installOpenedModules() {
+    auto&            state = getDeferredHookState();
+    std::unique_lock lock(state.mutex);
+    if (!hasPendingHooks(state, {})) { return; }
+    std::deque<LoadedModule> modules;
+    findPendingModules(state, modules);
+    for (auto& module : modules) installDeferredHooks(state, lock, module);
+}
+#endif
+
+static void runDeferredHookWorker(DeferredHookState& state) {
+    std::unique_lock lock(state.mutex);
+    while (true) {
+#ifdef _WIN32
+        state.cv.wait(lock, [&] { return !state.loaded.empty(); });
+#else
+        if (hasPendingHooks(state, {})) {
+            state.cv.wait_for(lock, DEFERRED_HOOK_POLL_DELAY);
+        } else {
+            state.cv.wait(lock);
+        }
+        collectLoadedModules(state);
+#endif
+        while (!state.loaded.empty()) {
+            auto module = std::move(state.loaded.front());
+            state.loaded.pop_front();
+            installDeferredHooks(state, lock, module);
+        }
+    }
+}
+
+#ifdef _WIN32
+// called by the loader with the loader lock held, so the scan is left to the worker
+static VOID CALLBACK onDllNotification(ULONG reason, LdrDllNotificationData const* data, PVOID) {
+    auto& state      = getDeferredHookState();
+    auto  moduleName = normalizeModuleName(utils::string_utils::wstr2str(
+        std::wstring_view{data->baseDllName->Buffer, data->baseDllName->Length / sizeof(WCHAR)}
+    ));
+    std::span image{(std::byte const*)data->dllBase, data->sizeOfImage};
+
+    if (reason == LDR_DLL_NOTIFICATION_REASON_LOADED) {
+        std::lock_guard lock(state.mutex);
+        if (!hasPendingHooks(state, moduleName)) { return; }
+        state.loaded.push_back({std::move(moduleName), image});
+        state.cv.notify_all();
+        return;
+    }
+    if (reason != LDR_DLL_NOTIFICATION_REASON_UNLOADED) { return; }
+
+    {
+        // nothing here may wait for another thread, which could be waiting for the loader lock. The code is
+        // unmapped when this returns, so the hooks are dropped instead of restored, see discardHooks
+        std::lock_guard lock(state.mutex);
+        std::erase_if(state.loaded, [&](LoadedModule const& item) { return item.image.data() == image.data(); });
+        for (auto& [id, hookData] : state.hooks) {
+            auto target = (std::byte const*)hookData.target;
+            if (!target || target < image.data() || target >= image.data() + image.size()) { continue; }
+            discardHooks(hookData.target);
+            hookData.target = nullptr;
+        }
+    }
+    eraseResolveCache(moduleName);
+}
+#endif
+
+static bool startDeferredHookWorker(DeferredHookState& state) {
+    if (state.started) { return true; }
+#ifdef _WIN32
+    auto registerNotification = (LdrRegisterDllNotificationFunction
+    )GetProcAddress(GetModuleHandleW(L"ntdll.dll"), "LdrRegisterDllNotification");
+    if (!registerNotification || registerNotification(0, &onDllNotification, nullptr, &state.cookie) != 0) {
+        return false;
+    }
+#endif
+    state.started = true;
+    std::thread([&state] { runDeferredHookWorker(state); }).detach();
+    return true;
+}
+
+int registerDeferredHook(
+    std::string_view moduleName,
+    std::string_view signature,
+    FuncPtr          detour,
+    FuncPtr*         originalFunc
+) {
+    auto& state = getDeferredHookState();
+    auto  name  = normalizeModuleName(moduleName);
+    int   id;
+    {
+        // the hook is known to the watcher before the module is looked up, so a concurrent load is not missed
+        std::lock_guard lock(state.mutex);
+        if (!startDeferredHookWorker(state)) { return -1; }
+        id = ++state.lastId;
+        state.hooks.emplace(id, DeferredHookData{name, std::string{signature}, detour, originalFunc});
+        state.cv.notify_all();
+    }
+
+    auto image = findModuleImage(name);
+    if (!image) { return id; }
+    auto            target = scanSignature(*image, std::string{signature}.c_str());
+    std::lock_guard lock(state.mutex);
+    auto            it = state.hooks.find(id);
+    if (it == state.hooks.end() || it->second.target) { return id; }
+    if (!target || hook(target, detour, originalFunc) != 0) {
+        state.hooks.erase(it);
+        return -1;
+    }
+    it->second.target = target;
+    return id;
+}
+
+bool removeDeferredHook(int id) {
+    auto&           state = getDeferredHookState();
+    std::lock_guard lock(state.mutex);
+    auto            it = state.hooks.find(id);
+    if (it == state.hooks.end()) { return false; }
+    if (it->second.target) { unhook(it->second.target, it->second.detour); }
+    state.hooks.erase(it);
+    return true;
+}
+
+bool isDeferredHookInstalled(int id) {
+    auto&           state = getDeferredHookState();
+    std::lock_guard lock(state.mutex);
+    auto            it = state.hooks.find(id);
+    return it != state.hooks.end() && it->second.target;
+}
+
+} // namespace glacie::memory
+
+#ifndef _WIN32
+// install the hooks of a module before dlopen returns to its caller. This only sees the calls which bind to it,
+// which are those of the main program and of the modules loaded after it, the worker catches every other load
+extern "C" [[gnu::visibility("default")]] void* dlopen(char const* file, int mode) {
+    using DlopenFunction   = void* (*)(char const*, int);
+    static auto realDlopen = (DlopenFunction)dlsym(RTLD_NEXT, "dlopen");
+    if (!realDlopen) { return nullptr; }
+    auto handle = realDlopen(file, mode);
+    if (handle) { glacie::memory::installOpenedModules(); }
+    return handle;
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "glacie/memory/Epoch.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <linux/membarrier.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace glacie::memory {
+
+constexpr auto EPOCH_RECLAIM_DELAY = std::chrono::milliseconds(1);
+
+struct RetiredItem {
+    uint64_t              epoch{};
+    std::function<void()> deleter{};
+};
+
+struct EpochState {
+    std::mutex                                mutex;
+    std::vector<std::unique_ptr<EpochRecord>> records;
+    std::deque<RetiredItem>                   retired;
+    std::condition_variable                   cv;
+    bool                                      barrierInitialized{};
+    bool                                      reclaimerStarted{};
+};
+
+EpochState& getEpochState() {
+    // never destroyed, threads may still release their records after exit
+    static auto& state = *new EpochState;
+    return state;
+}
+
+static void initProcessBarrier(EpochState& state) {
+    if (state.barrierInitialized) { return; }
+    state.barrierInitialized = true;
+#ifndef _WIN32
+    if (syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) != 0) {
+        epochNeedsFence.store(true, std::memory_order_relaxed);
+    }
+#endif
+}
+
+// make the epoch stores of every reader visible to the reclaimer
+static void processBarrier() {
+#ifdef _WIN32
+    FlushProcessWriteBuffers();
+#else
+    if (epochNeedsFence.load(std::memory_order_relaxed)
+        || syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) != 0) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+#endif
+}
+
+EpochRecord& registerEpochThread() {
+    struct RecordOwner {
+        EpochRecord* record{};
+        ~RecordOwner() {
+            if (!record) { return; }
+            currentEpochRecord = nullptr;
+            record->depth      = 0;
+            record->epoch.store(0, std::memory_order_release);
+            record->inUse.store(false, std::memory_order_release);
+        }
+    };
+    static thread_local RecordOwner owner;
+
+    auto&           state = getEpochState();
+    std::lock_guard lock(state.mutex);
+    initProcessBarrier(state);
+    EpochRecord* record = nullptr;
+    for (auto& item : state.records) {
+        if (!item->inUse.load(std::memory_order_acquire)) {
+            record = item.get();
+            break;
+        }
+    }
+    if (!record) { record = state.records.emplace_back(std::make_unique<EpochRecord>()).get(); }
+    record->inUse.store(true, std::memory_order_relaxed);
+    owner.record       = record;
+    currentEpochRecord = record;
+    return *record;
+}
+
+// the epoch can only move on once every thread inside a guard has seen the current one
+static bool tryAdvance(EpochState& state) {
+    processBarrier();
+    auto epoch = globalEpoch.load(std::memory_order_relaxed);
+    for (auto& record : state.records) {
+        auto local = record->epoch.load(std::memory_order_acquire);
+        if (local != 0 && local != epoch) { return false; }
+    }
+    globalEpoch.store(epoch + 1, std::memory_order_release);
+    return true;
+}
+
+// a guard may be held while the retiring thread calls reclaim, so the deleters would otherwise wait for
+// whoever calls reclaim next, which may never happen
+static void runReclaimer(EpochState& state) {
+    while (true) {
+        {
+            std::unique_lock lock(state.mutex);
+            state.cv.wait(lock, [&] { return !state.retired.empty(); });
+        }
+        while (!reclaim()) std::this_thread::sleep_for(EPOCH_RECLAIM_DELAY);
+    }
+}
+
+void retire(std::function<void()> deleter) {
+    auto&           state = getEpochState();
+    std::lock_guard lock(state.mutex);
+    state.retired.push_back({globalEpoch.load(), std::move(deleter)});
+    if (!state.reclaimerStarted) {
+        state.reclaimerStarted = true;
+        std::thread([&state] { runReclaimer(state); }).detach();
+    }
+    state.cv.notify_one();
+}
+
+bool reclaim() {
+    auto&                              state = getEpochState();
+    std::vector<std::function<void()>> ready;
+    bool                               empty;
+    {
+        std::lock_guard lock(state.mutex);
+        if (state.retired.empty()) { return true; }
+        for (int i = 0; i < 2 && tryAdvance(state); ++i) {}
+        // an item is safe once the epoch has moved twice since it was retired
+        auto epoch = globalEpoch.load(std::memory_order_relaxed);
+        while (!state.retired.empty() && state.retired.front().epoch + 2 <= epoch) {
+            ready.push_back(std::move(state.retired.front().deleter));
+            state.retired.pop_front();
+        }
+        empty = state.retired.empty();
+    }
+    for (auto& deleter : ready) {
+        if (deleter) { deleter(); }
+    }
+    return empty;
+}
+
+void synchronizeEpoch() {
+    std::atomic_bool done{};
+    retire([&done] { done.store(true, std::memory_order_release); });
+    while (!done.load(std::memory_order_acquire)) {
+        reclaim();
+        std::this_thread::yield();
+    }
+}
+
+} // namespace glacie::memory
\ No newline at end of file
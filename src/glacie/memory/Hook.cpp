@@ -1,13 +1,23 @@
 #include "glacie/memory/Hook.h"
+#include "glacie/memory/Epoch.h"
 #include "glacie/memory/Memory.h"
+#include "glacie/memory/SymbolIndex.h"
+#include "glacie/memory/Timeline.h"
+#include "glacie/memory/Trampoline.h"
 
+#include <atomic>
 #include <iostream>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
+#ifdef _WIN32
 #include <Windows.h>
 
 #include "detours/detours.h"
+#else
+#include <sys/mman.h>
+#endif
 
 namespace glacie::memory {
 
@@ -19,6 +29,8 @@ struct HookElement {
     bool operator<(const HookElement& other) const { return id < other.id; }
 };
 
+constexpr auto THUNK_SIZE = 18;
+
 struct HookData {
     FuncPtr               target{};
     FuncPtr               origin{};
@@ -26,27 +38,29 @@ struct HookData {
     FuncPtr               thunk{};
     int                   hookId{};
     std::set<HookElement> hooks{};
+    bool                  attached{}; // whether the prologue of target jumps to the thunk
 
+    // only called before the thunk was ever reachable, afterwards a hook data is kept for good
     inline ~HookData() {
         if (this->thunk != nullptr) {
+#ifdef _WIN32
             VirtualFree(this->thunk, 0, MEM_RELEASE);
+#else
+            munmap(this->thunk, THUNK_SIZE);
+#endif
             this->thunk = nullptr;
         }
     }
 
+    // other threads walk the chain while it is rewritten, so it is linked from the back and every slot is
+    // published with a release store only after everything behind it is in place
     inline void updateCallList() {
-        FuncPtr* last = nullptr;
-        for (auto& item : this->hooks) {
-            if (last == nullptr) {
-                this->start = item.detour;
-                last        = item.originalFunc;
-            } else {
-                *last = item.detour;
-                last  = item.originalFunc;
-            }
+        FuncPtr next = this->origin;
+        for (auto it = this->hooks.rbegin(); it != this->hooks.rend(); ++it) {
+            std::atomic_ref(*it->originalFunc).store(next, std::memory_order_release);
+            next = it->detour;
         }
-        if (last == nullptr) this->start = this->origin;
-        else *last = this->origin;
+        std::atomic_ref(this->start).store(next, std::memory_order_release);
     }
 
     inline int incrementHookId() { return ++hookId; }
@@ -56,35 +70,59 @@ std::unordered_map<FuncPtr, std::shared_ptr<HookData>>& getHooks() {
     static std::unordered_map<FuncPtr, std::shared_ptr<HookData>> hooks;
     return hooks;
 }
+// hook data of unloaded modules, threads may still be on their way through the thunk
+std::vector<std::shared_ptr<HookData>>& getDiscardedHooks() {
+    static std::vector<std::shared_ptr<HookData>> discarded;
+    return discarded;
+}
 std::mutex& getHooksMutex() {
     static std::mutex hooksMutex;
     return hooksMutex;
 }
 
 FuncPtr createThunk(FuncPtr* target) {
-    constexpr auto THUNK_SIZE            = 18;
-    unsigned char  thunkData[THUNK_SIZE] = {0};
-    // generate a thunk:
-    // mov rax hooker1
-    thunkData[0] = 0x48;
-    thunkData[1] = 0xB8;
+    unsigned char thunkData[THUNK_SIZE] = {0};
+    // generate a thunk, r11 is scratch on both ABIs while al carries the vector count of variadic calls on SysV:
+    // mov r11 hooker1
+    thunkData[0] = 0x49;
+    thunkData[1] = 0xBB;
     memcpy(thunkData + 2, &target, sizeof(FuncPtr*));
-    // mov rax [rax]
-    thunkData[10] = 0x48;
+    // mov r11 [r11]
+    thunkData[10] = 0x4D;
     thunkData[11] = 0x8B;
-    thunkData[12] = 0x00;
-    // jmp rax
-    thunkData[13] = 0xFF;
-    thunkData[14] = 0xE0;
+    thunkData[12] = 0x1B;
+    // jmp r11
+    thunkData[13] = 0x41;
+    thunkData[14] = 0xFF;
+    thunkData[15] = 0xE3;
 
+#ifdef _WIN32
     auto thunk = VirtualAlloc(nullptr, THUNK_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
     memcpy(thunk, thunkData, THUNK_SIZE);
     DWORD dummy;
     VirtualProtect(thunk, THUNK_SIZE, PAGE_EXECUTE_READ, &dummy);
+#else
+    auto thunk = mmap(nullptr, THUNK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    memcpy(thunk, thunkData, THUNK_SIZE);
+    mprotect(thunk, THUNK_SIZE, PROT_READ | PROT_EXEC);
+#endif
     return thunk;
 }
 
+std::atomic_bool& getLivePatching() {
+    static std::atomic_bool livePatching{};
+    return livePatching;
+}
+
+void setLivePatching(bool enabled) { getLivePatching().store(enabled, std::memory_order_relaxed); }
+
+bool isLivePatching() { return getLivePatching().load(std::memory_order_relaxed); }
+
 int processHook(FuncPtr target, FuncPtr detour, FuncPtr* originalFunc) {
+    TimelineScope timeline(TimelineEventKind::ProcessHook, target);
+#ifdef _WIN32
+    // Detours only suspends the threads it is told about
+    if (isLivePatching()) { return attachTrampoline(target, detour, originalFunc, true); }
     FuncPtr tmp = target;
     DetourTransactionBegin();
     DetourUpdateThread(GetCurrentThread());
@@ -92,45 +130,114 @@ int processHook(FuncPtr target, FuncPtr detour, FuncPtr* originalFunc) {
     DetourTransactionCommit();
     *originalFunc = tmp;
     return rv;
+#else
+    return attachTrampoline(target, detour, originalFunc, isLivePatching());
+#endif
+}
+
+int processUnhook(FuncPtr detour, FuncPtr* originalFunc) {
+#ifdef _WIN32
+    // hooks installed in live mode belong to the trampoline engine
+    if (detachTrampoline(originalFunc) == 0) { return 0; }
+    DetourTransactionBegin();
+    DetourUpdateThread(GetCurrentThread());
+    int rv = DetourDetach(originalFunc, detour);
+    if (rv != NO_ERROR) {
+        DetourTransactionAbort();
+        return rv;
+    }
+    return DetourTransactionCommit();
+#else
+    // the trampoline knows its target
+    (void)detour;
+    return detachTrampoline(originalFunc);
+#endif
 }
 
 [[maybe_unused]] int hook(FuncPtr target, FuncPtr detour, FuncPtr* originalFunc) {
+    TimelineScope   timeline(TimelineEventKind::Hook, target);
     std::lock_guard lock(getHooksMutex());
     auto            it = getHooks().find(target);
-    if (it != getHooks().end()) {
+    if (it != getHooks().end() && it->second->attached) {
         auto hookData = it->second;
         hookData->hooks.insert({detour, originalFunc, hookData->incrementHookId()});
         hookData->updateCallList();
-        return ERROR_SUCCESS;
+        return 0;
     }
 
-    auto hookData   = new HookData{target, target, detour, nullptr, {}, {}};
-    hookData->thunk = createThunk(&hookData->start);
-    hookData->hooks.insert({detour, originalFunc, hookData->incrementHookId()});
-    auto ret = processHook(target, hookData->thunk, &hookData->origin);
-    if (ret) {
-        delete hookData;
-        return ret;
+    // a target which was hooked before gets its old thunk back, see retireHookData
+    auto hookData = it != getHooks().end() ? it->second : nullptr;
+    if (!hookData) {
+        hookData        = std::shared_ptr<HookData>(new HookData{target, target, target, nullptr, {}, {}});
+        hookData->thunk = createThunk(&hookData->start);
     }
+    // until the chain is linked, a thread which takes the new jump loops through the thunk back to target
+    std::atomic_ref(hookData->start).store(target, std::memory_order_release);
+    auto ret = processHook(target, hookData->thunk, &hookData->origin);
+    if (ret) { return ret; }
+    hookData->attached = true;
+    hookData->hooks.insert({detour, originalFunc, hookData->incrementHookId()});
     hookData->updateCallList();
-    getHooks().emplace(target, std::shared_ptr<HookData>(hookData));
-    return ERROR_SUCCESS;
+    getHooks().emplace(target, hookData);
+    return 0;
+}
+
+// restore the original prologue once no thread can still be inside a removed detour, which may call the
+// trampoline. The epoch does not cover the way from the prologue through the thunk to the guard of a
+// detour, so the thunk and the slot it reads are never released and a thread on that way continues into
+// target. The hook data is reused when target is hooked again.
+void retireHookData(FuncPtr target, std::shared_ptr<HookData> const& hookData) {
+    retire([target, hookData] {
+        std::lock_guard lock(getHooksMutex());
+        // the target may have been hooked again in the meantime
+        if (!hookData->attached || !hookData->hooks.empty()) { return; }
+        // the trampoline may be released by the detach, until the prologue is restored the thunk loops back
+        std::atomic_ref(hookData->start).store(target, std::memory_order_release);
+        if (processUnhook(hookData->thunk, &hookData->origin)) {
+            hookData->updateCallList();
+            return;
+        }
+        hookData->attached = false;
+    });
 }
 
 [[maybe_unused]] bool unhook(FuncPtr target, FuncPtr detour) {
-    std::lock_guard lock(getHooksMutex());
-    auto            hookDataIter = getHooks().find(target);
-    if (hookDataIter == getHooks().end()) { return false; }
-    auto& hookData = hookDataIter->second;
-    for (auto it = hookData->hooks.begin(); it != hookData->hooks.end(); ++it) {
-        if (it->detour != detour) continue;
-        hookData->hooks.erase(it);
-        hookData->updateCallList();
-        return true;
+    bool result = false;
+    {
+        std::lock_guard lock(getHooksMutex());
+        auto            hookDataIter = getHooks().find(target);
+        if (hookDataIter == getHooks().end()) { return false; }
+        auto& hookData = hookDataIter->second;
+        for (auto it = hookData->hooks.begin(); it != hookData->hooks.end(); ++it) {
+            if (it->detour != detour) continue;
+            hookData->hooks.erase(it);
+            hookData->updateCallList();
+            if (hookData->hooks.empty()) { retireHookData(target, hookData); }
+            result = true;
+            break;
+        }
     }
-    return false;
+    reclaim();
+    return result;
+}
+
+void discardHooks(FuncPtr target) {
+    std::lock_guard lock(getHooksMutex());
+    auto            it = getHooks().find(target);
+    if (it == getHooks().end()) { return; }
+    auto& hookData = it->second;
+    // a pending retireHookData sees the hook data detached and leaves the prologue alone
+    if (hookData->attached) { discardTrampoline(&hookData->origin); }
+    hookData->attached = false;
+    hookData->hooks.clear();
+    getDiscardedHooks().push_back(std::move(hookData));
+    getHooks().erase(it);
 }
 
-FuncPtr resolveIdentifier(char const* identifier) { return resolveSignature(identifier); }
+FuncPtr resolveIdentifier(char const* identifier) {
+    TimelineScope timeline(TimelineEventKind::ResolveIdentifier, identifier);
+    if (isSymbolIdentifier(identifier)) { return resolveSymbol(identifier); }
+    return resolveSignature(identifier);
+}
 
 } // namespace glacie::memory
\ No newline at end of file
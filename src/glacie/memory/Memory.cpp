@@ -1,11 +1,12 @@
 #include "glacie/memory/Memory.h"
+#include "glacie/memory/OffsetTable.h"
+
+#include "glacie/memory/PatchBatch.h"
+#include "glacie/memory/Timeline.h"
 
 #include <cstddef>
 #include <functional>
 #include <iostream>
-#include <libloaderapi.h>
-#include <memoryapi.h>
-#include <minwindef.h>
 #include <ranges>
 #include <string>
 #include <string_view>
@@ -13,22 +14,84 @@
 
 #include "glacie/utils/StringUtils.h"
 #include "glacie/utils/WinUtils.h"
-#include "libhat/Process.hpp"
 #include "libhat/Scanner.hpp"
 #include "libhat/Signature.hpp"
 
+#ifdef _WIN32
+#include <libloaderapi.h>
+#include <memoryapi.h>
+#include <minwindef.h>
+
 #include "windows.h"
-#include <libhat.hpp>
 #include <winnt.h>
+#else
+#include <dlfcn.h>
+#include <link.h>
+#endif
 
 using namespace glacie::utils;
 
 namespace glacie::memory {
 
 FuncPtr resolveSignature(const char* signature) {
-    auto module = hat::process::get_module("bedrock_server.exe");
-    if (!module.has_value()) return nullptr;
-    auto                                moduleData = hat::process::get_module_data(module.value());
+    TimelineScope timeline(TimelineEventKind::ResolveSignature, signature);
+    if (auto address = findOffsetTable(signature)) {
+        timeline.setCacheHit(true);
+        return address;
+    }
+    return resolveSignature(serverModuleName, signature);
+}
+
+FuncPtr resolveSignature(const char* moduleName, const char* signature) {
+    TimelineScope timeline(TimelineEventKind::ResolveSignature, signature);
+    timeline.setCacheHit(true);
+    return resolveCached(moduleName, signature, [&] {
+        timeline.setCacheHit(false);
+        return scanSignature(moduleName, signature);
+    });
+}
+
+FuncPtr scanSignature(const char* signature) { return scanSignature(serverModuleName, signature); }
+
+#ifndef _WIN32
+struct CodeSearch {
+    std::string_view           moduleName;
+    std::span<std::byte const> range;
+};
+
+// the gaps between the segments of an ELF image are mapped inaccessible, so only the code is scanned
+static std::span<std::byte const> getModuleCode(std::string_view moduleName) {
+    CodeSearch search{moduleName, {}};
+    dl_iterate_phdr(
+        [](dl_phdr_info* info, size_t, void* data) {
+            auto&            search = *(CodeSearch*)data;
+            std::string_view path   = info->dlpi_name ? info->dlpi_name : "";
+            if (!search.moduleName.empty() && path.substr(path.find_last_of('/') + 1) != search.moduleName) {
+                return 0;
+            }
+            for (int i = 0; i < info->dlpi_phnum; ++i) {
+                auto& header = info->dlpi_phdr[i];
+                if (header.p_type != PT_LOAD || !(header.p_flags & PF_X)) { continue; }
+                search.range = {(std::byte const*)(info->dlpi_addr + header.p_vaddr), header.p_memsz};
+                break;
+            }
+            return 1;
+        },
+        &search
+    );
+    return search.range;
+}
+#endif
+
+static std::span<std::byte const> getScanRange(const char* moduleName) {
+#ifdef _WIN32
+    return std::as_bytes(win_utils::getImageRange(moduleName));
+#else
+    return getModuleCode(moduleName);
+#endif
+}
+
+static std::vector<hat::signature_element> parseSignature(const char* signature) {
     std::vector<hat::signature_element> elements;
     for (std::string_view const& sv : glacie::utils::string_utils::splitByPattern(signature, " ")) {
         if (sv.starts_with('?')) {
@@ -40,18 +103,105 @@ FuncPtr resolveSignature(const char* signature) {
             ));
         }
     }
-    auto result = hat::find_pattern(moduleData.begin(), moduleData.end(), hat::signature_view(elements));
-    return reinterpret_cast<FuncPtr>(result.get());
+    return elements;
+}
+
+FuncPtr scanSignature(const char* moduleName, const char* signature) {
+    auto image = getScanRange(moduleName);
+    if (image.empty()) return nullptr;
+    return scanSignature(image, signature);
+}
+
+FuncPtr scanSignature(std::span<std::byte const> range, const char* signature) {
+    auto elements = parseSignature(signature);
+    auto result   = hat::find_pattern(range.begin(), range.end(), hat::signature_view(elements));
+    addTimelineBytes(result.get() ? (result.get() - range.data()) + elements.size() : range.size());
+    return (FuncPtr)result.get();
+}
+
+size_t findAll(
+    std::span<std::byte const>          range,
+    const char*                         signature,
+    const std::function<bool(FuncPtr)>& callback,
+    size_t                              limit
+) {
+    auto elements = parseSignature(signature);
+    if (elements.empty()) { return 0; }
+    size_t count = 0, scanned = 0;
+    // each search resumes right after the previous match, so the range is only walked once
+    for (auto begin = range.begin(); begin != range.end() && (!limit || count < limit);) {
+        auto result = hat::find_pattern(begin, range.end(), hat::signature_view(elements));
+        if (!result.get()) {
+            scanned = range.size();
+            break;
+        }
+        auto offset = (size_t)(result.get() - range.data());
+        scanned     = offset + elements.size();
+        ++count;
+        if (!callback((FuncPtr)result.get())) { break; }
+        begin = range.begin() + offset + 1;
+    }
+    addTimelineBytes(scanned);
+    return count;
+}
+
+size_t findAll(
+    const char*                         moduleName,
+    const char*                         signature,
+    const std::function<bool(FuncPtr)>& callback,
+    size_t                              limit
+) {
+    auto image = getScanRange(moduleName);
+    if (image.empty()) { return 0; }
+    return findAll(image, signature, callback, limit);
+}
+
+std::vector<FuncPtr> findAll(const char* signature, size_t limit) {
+    std::vector<FuncPtr> result;
+    findAll(
+        serverModuleName,
+        signature,
+        [&](FuncPtr address) {
+            result.push_back(address);
+            return true;
+        },
+        limit
+    );
+    return result;
+}
+
+size_t patchAll(
+    PatchBatch&              batch,
+    const char*              signature,
+    std::span<uint8_t const> bytes,
+    ptrdiff_t                offset,
+    size_t                   limit
+) {
+    return findAll(
+        serverModuleName,
+        signature,
+        [&](FuncPtr address) {
+            batch.add((uint8_t*)address + offset, bytes);
+            return true;
+        },
+        limit
+    );
 }
 
 void modify(void* ptr, size_t len, const std::function<void()>& callback) {
+#ifdef _WIN32
     DWORD oldProtect;
     VirtualProtect(ptr, len, PAGE_EXECUTE_READWRITE, &oldProtect);
     callback();
     VirtualProtect(ptr, len, oldProtect, &oldProtect);
+#else
+    // mprotect does not return the previous protection, the batch reads it from the mappings
+    PatchBatch{}.touch(ptr, len).commit(callback);
+#endif
 }
 
 Handle getModuleHandle(void* addr) {
+#ifdef _WIN32
     HMODULE hModule = nullptr;
     GetModuleHandleEx(
         GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
@@ -59,6 +209,11 @@ Handle getModuleHandle(void* addr) {
         &hModule
     );
     return hModule;
+#else
+    Dl_info info;
+    if (!dladdr(addr, &info)) { return nullptr; }
+    return info.dli_fbase;
+#endif
 }
 
 } // namespace glacie::memory
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include "glacie/memory/OffsetTable.h"
+#include "glacie/memory/Memory.h"
+#include "glacie/memory/ResolveCache.h"
+#include "glacie/memory/SymbolIndex.h"
+
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "glacie/utils/FileUtils.h"
+
+namespace glacie::memory {
+
+namespace {
+
+// PE and ELF64 structures, declared here so that the offline resolver can read images on every platform
+struct PeFileHeader {
+    uint16_t machine;
+    uint16_t numberOfSections;
+    uint32_t timeDateStamp;
+    uint32_t pointerToSymbolTable;
+    uint32_t numberOfSymbols;
+    uint16_t sizeOfOptionalHeader;
+    uint16_t characteristics;
+};
+
+struct PeSection {
+    char     name[8];
+    uint32_t virtualSize;
+    uint32_t virtualAddress;
+    uint32_t sizeOfRawData;
+    uint32_t pointerToRawData;
+    uint32_t pointerToRelocations;
+    uint32_t pointerToLinenumbers;
+    uint16_t numberOfRelocations;
+    uint16_t numberOfLinenumbers;
+    uint32_t characteristics;
+};
+
+struct ElfHeader {
+    uint8_t  ident[16];
+    uint16_t type;
+    uint16_t machine;
+    uint32_t version;
+    uint64_t entry;
+    uint64_t phoff;
+    uint64_t shoff;
+    uint32_t flags;
+    uint16_t ehsize;
+    uint16_t phentsize;
+    uint16_t phnum;
+    uint16_t shentsize;
+    uint16_t shnum;
+    uint16_t shstrndx;
+};
+
+struct ElfSegment {
+    uint32_t type;
+    uint32_t flags;
+    uint64_t offset;
+    uint64_t vaddr;
+    uint64_t paddr;
+    uint64_t filesz;
+    uint64_t memsz;
+    uint64_t align;
+};
+
+constexpr uint8_t  ELF_MAGIC[4]            = {0x7F, 'E', 'L', 'F'};
+constexpr uint32_t ELF_SEGMENT_LOAD        = 1;
+constexpr uint32_t ELF_SEGMENT_NOTE        = 4;
+constexpr uint32_t ELF_SEGMENT_EXECUTE     = 1;
+constexpr uint32_t ELF_NOTE_GNU_BUILD_ID   = 3;
+constexpr uint32_t PE_SIGNATURE            = 0x00004550; // "PE\0\0"
+constexpr uint32_t PE_SECTION_EXECUTE      = 0x20000000;
+constexpr size_t   PE_SIZE_OF_IMAGE_OFFSET = 56; // in the optional header
+
+// a range of the file which is mapped at an RVA
+struct ImageRange {
+    uint64_t offset;
+    uint64_t size;
+    uint64_t rva;
+};
+
+template <class T>
+bool readAt(std::span<uint8_t const> file, uint64_t offset, T& value) {
+    if (offset > file.size() || file.size() - offset < sizeof(T)) { return false; }
+    memcpy(&value, file.data() + offset, sizeof(T));
+    return true;
+}
+
+bool isPeImage(std::span<uint8_t const> file) { return file.size() >= 0x40 && file[0] == 'M' && file[1] == 'Z'; }
+
+bool isElfImage(std::span<uint8_t const> file) {
+    return file.size() >= sizeof(ElfHeader) && memcmp(file.data(), ELF_MAGIC, sizeof(ELF_MAGIC)) == 0;
+}
+
+std::optional<uint64_t> getPeHeadersOffset(std::span<uint8_t const> file) {
+    uint32_t headersOffset, signature;
+    if (!readAt(file, 0x3C, headersOffset) || !readAt(file, headersOffset, signature) || signature != PE_SIGNATURE) {
+        return std::nullopt;
+    }
+    return headersOffset + sizeof(signature);
+}
+
+std::vector<ImageRange> getExecutableRanges(std::span<uint8_t const> file) {
+    std::vector<ImageRange> result;
+    if (isPeImage(file)) {
+        auto         fileHeaderOffset = getPeHeadersOffset(file);
+        PeFileHeader fileHeader;
+        if (!fileHeaderOffset || !readAt(file, *fileHeaderOffset, fileHeader)) { return result; }
+        auto sectionOffset = *fileHeaderOffset + sizeof(PeFileHeader) + fileHeader.sizeOfOptionalHeader;
+        for (uint16_t i = 0; i < fileHeader.numberOfSections; ++i) {
+            PeSection section;
+            if (!readAt(file, sectionOffset + i * sizeof(PeSection), section)) { break; }
+            if (!(section.characteristics & PE_SECTION_EXECUTE)) { continue; }
+            result.push_back({section.pointerToRawData, section.sizeOfRawData, section.virtualAddress});
+        }
+    } else if (isElfImage(file)) {
+        ElfHeader header;
+        readAt(file, 0, header);
+        for (uint16_t i = 0; i < header.phnum; ++i) {
+            ElfSegment segment;
+            if (!readAt(file, header.phoff + i * sizeof(ElfSegment), segment)) { break; }
+            if (segment.type != ELF_SEGMENT_LOAD || !(segment.flags & ELF_SEGMENT_EXECUTE)) { continue; }
+            result.push_back({segment.offset, segment.filesz, segment.vaddr});
+        }
+    }
+    std::erase_if(result, [&](ImageRange const& range) {
+        return range.offset > file.size() || file.size() - range.offset < range.size;
+    });
+    return result;
+}
+
+std::optional<uint64_t> getElfBuildId(std::span<uint8_t const> file) {
+    ElfHeader header;
+    readAt(file, 0, header);
+    for (uint16_t i = 0; i < header.phnum; ++i) {
+        ElfSegment segment;
+        if (!readAt(file, header.phoff + i * sizeof(ElfSegment), segment)) { break; }
+        if (segment.type != ELF_SEGMENT_NOTE) { continue; }
+        // each note is namesz, descsz and type, then the name and the descriptor padded to 4 bytes
+        for (uint64_t offset = segment.offset; offset + 12 <= segment.offset + segment.filesz;) {
+            uint32_t note[3];
+            if (!readAt(file, offset, note)) { break; }
+            auto name = offset + 12;
+            auto desc = name + ((note[0] + 3) & ~3u);
+            offset    = desc + ((note[1] + 3) & ~3u);
+            if (note[2] != ELF_NOTE_GNU_BUILD_ID || note[0] != 4 || desc + note[1] > file.size()) { continue; }
+            if (memcmp(file.data() + name, "GNU", 4) != 0) { continue; }
+            return hashIdentifier({(char const*)file.data() + desc, note[1]});
+        }
+    }
+    return std::nullopt;
+}
+
+} // namespace
+
+std::optional<uint64_t> getImageFingerprint(std::span<uint8_t const> file) {
+    if (isElfImage(file)) { return getElfBuildId(file); }
+    if (!isPeImage(file)) { return std::nullopt; }
+    auto         fileHeaderOffset = getPeHeadersOffset(file);
+    PeFileHeader fileHeader;
+    uint32_t     sizeOfImage;
+    if (!fileHeaderOffset || !readAt(file, *fileHeaderOffset, fileHeader)
+        || !readAt(file, *fileHeaderOffset + sizeof(PeFileHeader) + PE_SIZE_OF_IMAGE_OFFSET, sizeOfImage)) {
+        return std::nullopt;
+    }
+    return (uint64_t)fileHeader.timeDateStamp << 32 | sizeOfImage;
+}
+
+std::optional<uint64_t> getServerFingerprint() {
+    utils::file_utils::MappedFile file(getServerPath().string());
+    if (!file.isOpen()) { return std::nullopt; }
+    return getImageFingerprint(file.getData());
+}
+
+std::optional<uint64_t> scanImageSignature(std::span<uint8_t const> file, char const* signature) {
+    for (auto& range : getExecutableRanges(file)) {
+        auto data   = std::span{(std::byte const*)file.data() + range.offset, range.size};
+        auto result = (std::byte const*)scanSignature(data, signature);
+        if (result) { return range.rva + (result - data.data()); }
+    }
+    return std::nullopt;
+}
+
+struct OffsetTableState {
+    std::shared_mutex                              mutex;
+    std::unordered_map<std::string_view, uint64_t> offsets;
+    std::optional<uint64_t>                        serverFingerprint;
+    std::optional<uintptr_t>                       serverBase; // 0 for a main program which is not PIE
+    bool                                           initialized{};
+};
+
+OffsetTableState& getOffsetTableState() {
+    static OffsetTableState state;
+    return state;
+}
+
+bool registerOffsetTable(uint64_t fingerprint, std::span<OffsetEntry const> entries) {
+    auto&            state = getOffsetTableState();
+    std::unique_lock lock(state.mutex);
+    if (!state.initialized) {
+        state.initialized       = true;
+        state.serverFingerprint = getServerFingerprint();
+        state.serverBase        = getServerBase();
+    }
+    if (state.serverFingerprint != fingerprint || !state.serverBase.has_value()) { return false; }
+    for (auto& entry : entries) state.offsets.try_emplace(entry.signature, entry.rva);
+    return true;
+}
+
+FuncPtr findOffsetTable(std::string_view signature) {
+    auto&            state = getOffsetTableState();
+    std::shared_lock lock(state.mutex);
+    auto             it = state.offsets.find(signature);
+    if (it == state.offsets.end()) { return nullptr; }
+    return reinterpret_cast<FuncPtr>(*state.serverBase + it->second);
+}
+
+} // namespace glacie::memory
\ No newline at end of file
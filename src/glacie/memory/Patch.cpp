@@ -0,0 +1,108 @@
+#include "glacie/memory/Patch.h"
+#include "glacie/memory/PatchBatch.h"
+
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace glacie::memory {
+
+struct PatchData {
+    uintptr_t            address{};
+    std::vector<uint8_t> original{};
+    std::vector<uint8_t> patched{};
+    bool                 enabled{};
+};
+
+struct PatchRegistry {
+    std::map<uintptr_t, int>           byAddress;
+    std::unordered_map<int, PatchData> patches;
+    int                                lastId{};
+};
+
+PatchRegistry& getPatchRegistry() {
+    static PatchRegistry registry;
+    return registry;
+}
+std::mutex& getPatchRegistryMutex() {
+    static std::mutex registryMutex;
+    return registryMutex;
+}
+
+static bool isOverlapped(PatchRegistry& registry, uintptr_t begin, uintptr_t end) {
+    auto it = registry.byAddress.lower_bound(begin);
+    if (it != registry.byAddress.end() && it->first < end) { return true; }
+    if (it != registry.byAddress.begin()) {
+        auto& prev = registry.patches.at(std::prev(it)->second);
+        if (prev.address + prev.patched.size() > begin) { return true; }
+    }
+    return false;
+}
+
+int registerPatch(void* address, std::span<uint8_t const> bytes, bool enable) {
+    if (address == nullptr || bytes.empty()) { return -1; }
+    std::lock_guard lock(getPatchRegistryMutex());
+    auto&           registry = getPatchRegistry();
+    auto            begin    = (uintptr_t)address;
+    if (isOverlapped(registry, begin, begin + bytes.size())) { return -1; }
+
+    PatchData data{begin, std::vector<uint8_t>(bytes.size()), {bytes.begin(), bytes.end()}, false};
+    memcpy(data.original.data(), address, bytes.size());
+    if (enable) {
+        if (!PatchBatch{}.add(address, bytes).commit()) { return -1; }
+        data.enabled = true;
+    }
+    auto id = ++registry.lastId;
+    registry.byAddress.emplace(begin, id);
+    registry.patches.emplace(id, std::move(data));
+    return id;
+}
+
+int registerPatch(char const* identifier, ptrdiff_t offset, std::span<uint8_t const> bytes, bool enable) {
+    auto address = resolveIdentifier(identifier);
+    if (address == nullptr) { return -1; }
+    return registerPatch((void*)((uintptr_t)address + offset), bytes, enable);
+}
+
+bool removePatch(int id) {
+    std::lock_guard lock(getPatchRegistryMutex());
+    auto&           registry = getPatchRegistry();
+    auto            it       = registry.patches.find(id);
+    if (it == registry.patches.end()) { return false; }
+    auto& data = it->second;
+    if (data.enabled && !PatchBatch{}.add((void*)data.address, data.original).commit()) { return false; }
+    registry.byAddress.erase(data.address);
+    registry.patches.erase(it);
+    return true;
+}
+
+bool setPatchesEnabled(std::span<int const> ids, bool enable) {
+    std::lock_guard         lock(getPatchRegistryMutex());
+    auto&                   registry = getPatchRegistry();
+    PatchBatch              batch;
+    std::vector<PatchData*> changed;
+    changed.reserve(ids.size());
+    for (auto id : ids) {
+        auto it = registry.patches.find(id);
+        if (it == registry.patches.end()) { return false; }
+        auto& data = it->second;
+        if (data.enabled == enable) { continue; }
+        batch.add((void*)data.address, enable ? data.patched : data.original);
+        changed.push_back(&data);
+    }
+    if (!batch.commit()) { return false; }
+    for (auto data : changed) data->enabled = enable;
+    return true;
+}
+
+bool isPatchEnabled(int id) {
+    std::lock_guard lock(getPatchRegistryMutex());
+    auto&           registry = getPatchRegistry();
+    auto            it       = registry.patches.find(id);
+    return it != registry.patches.end() && it->second.enabled;
+}
+
+} // namespace glacie::memory
\ No newline at end of file
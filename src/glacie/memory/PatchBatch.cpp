@@ -0,0 +1,200 @@
+#include "glacie/memory/PatchBatch.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace glacie::memory {
+
+namespace {
+
+uintptr_t getPageSize() {
+#ifdef _WIN32
+    static uintptr_t pageSize = [] {
+        SYSTEM_INFO info;
+        GetSystemInfo(&info);
+        return (uintptr_t)info.dwPageSize;
+    }();
+#else
+    static uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+#endif
+    return pageSize;
+}
+
+#ifndef _WIN32
+// the kernel does not report the previous protection, so it is read from the mappings
+std::string readProcessMaps() {
+    std::string result;
+    FILE*       file = fopen("/proc/self/maps", "r");
+    if (!file) { return result; }
+    char   buf[4096];
+    size_t read;
+    while ((read = fread(buf, 1, sizeof(buf), file)) > 0) result.append(buf, read);
+    fclose(file);
+    return result;
+}
+
+template <class F>
+void forEachMapping(std::string const& maps, F&& callback) {
+    char const* line = maps.c_str();
+    while (*line) {
+        char*     next;
+        uintptr_t begin = strtoull(line, &next, 16);
+        uintptr_t end   = strtoull(next + 1, &next, 16);
+        int       prot  = PROT_NONE;
+        if (next[1] == 'r') prot |= PROT_READ;
+        if (next[2] == 'w') prot |= PROT_WRITE;
+        if (next[3] == 'x') prot |= PROT_EXEC;
+        if (!callback(begin, end, prot)) { return; }
+        line = strchr(next, '\n');
+        if (!line) { return; }
+        ++line;
+    }
+}
+#endif
+
+} // namespace
+
+PatchBatch& PatchBatch::add(void* address, std::span<uint8_t const> bytes) {
+    if (bytes.empty()) { return *this; }
+    writes.push_back({(uint8_t*)address, data.size(), bytes.size()});
+    data.insert(data.end(), bytes.begin(), bytes.end());
+    return touch(address, bytes.size());
+}
+
+PatchBatch& PatchBatch::fill(void* address, uint8_t value, size_t count) {
+    if (count == 0) { return *this; }
+    writes.push_back({(uint8_t*)address, data.size(), count});
+    data.insert(data.end(), count, value);
+    return touch(address, count);
+}
+
+PatchBatch& PatchBatch::touch(void* address, size_t len) {
+    if (len == 0) { return *this; }
+    ranges.push_back({(uintptr_t)address, (uintptr_t)address + len});
+    return *this;
+}
+
+void PatchBatch::clear() {
+    writes.clear();
+    data.clear();
+    ranges.clear();
+    regions.clear();
+}
+
+bool PatchBatch::unprotect() {
+    regions.clear();
+    if (ranges.empty()) { return true; }
+
+    // coalesce the touched ranges into runs of whole pages
+    auto const         pageMask = getPageSize() - 1;
+    std::vector<Range> pages;
+    pages.reserve(ranges.size());
+    for (auto& range : ranges) pages.push_back({range.begin & ~pageMask, (range.end + pageMask) & ~pageMask});
+    std::sort(pages.begin(), pages.end(), [](Range const& a, Range const& b) { return a.begin < b.begin; });
+    size_t count = 0;
+    for (auto& page : pages) {
+        if (count != 0 && page.begin <= pages[count - 1].end) {
+            pages[count - 1].end = std::max(pages[count - 1].end, page.end);
+        } else {
+            pages[count++] = page;
+        }
+    }
+    pages.resize(count);
+
+#ifdef _WIN32
+    for (auto& run : pages) {
+        // a single page has a single protection, larger runs are split at region boundaries
+        for (uintptr_t begin = run.begin; begin < run.end;) {
+            uintptr_t end = run.end;
+            if (end - begin > pageMask + 1) {
+                MEMORY_BASIC_INFORMATION info;
+                if (!VirtualQuery((void*)begin, &info, sizeof(info))) {
+                    restore();
+                    return false;
+                }
+                end = std::min(end, (uintptr_t)info.BaseAddress + info.RegionSize);
+            }
+            DWORD oldProtect;
+            if (!VirtualProtect((void*)begin, end - begin, PAGE_EXECUTE_READWRITE, &oldProtect)) {
+                restore();
+                return false;
+            }
+            regions.push_back({begin, end - begin, oldProtect});
+            begin = end;
+        }
+    }
+#else
+    auto   maps    = readProcessMaps();
+    size_t current = 0;
+    bool   success = true;
+    forEachMapping(maps, [&](uintptr_t begin, uintptr_t end, int prot) {
+        while (current < pages.size()) {
+            auto& run = pages[current];
+            if (end <= run.begin) { return true; }
+            if (run.begin < begin) {
+                // part of the run is not mapped
+                success = false;
+                return false;
+            }
+            auto chunkEnd = std::min(end, run.end);
+            if (mprotect((void*)run.begin, chunkEnd - run.begin, PROT_READ | PROT_WRITE | PROT_EXEC) != 0) {
+                success = false;
+                return false;
+            }
+            regions.push_back({run.begin, chunkEnd - run.begin, (uint32_t)prot});
+            if (chunkEnd != run.end) {
+                run.begin = chunkEnd;
+                return true;
+            }
+            ++current;
+        }
+        return false;
+    });
+    if (current != pages.size()) { success = false; }
+    if (!success) {
+        restore();
+        return false;
+    }
+#endif
+    return true;
+}
+
+void PatchBatch::applyWrites() {
+    for (auto& write : writes) memcpy(write.address, data.data() + write.offset, write.size);
+}
+
+void PatchBatch::restore() {
+    if (regions.empty()) { return; }
+    uintptr_t flushBegin = UINTPTR_MAX;
+    uintptr_t flushEnd   = 0;
+    for (auto& range : ranges) {
+        flushBegin = std::min(flushBegin, range.begin);
+        flushEnd   = std::max(flushEnd, range.end);
+    }
+    for (auto it = regions.rbegin(); it != regions.rend(); ++it) {
+#ifdef _WIN32
+        DWORD dummy;
+        VirtualProtect((void*)it->begin, it->size, it->protect, &dummy);
+#else
+        mprotect((void*)it->begin, it->size, (int)it->protect);
+#endif
+    }
+    regions.clear();
+#ifdef _WIN32
+    FlushInstructionCache(GetCurrentProcess(), (void*)flushBegin, flushEnd - flushBegin);
+#else
+    __builtin___clear_cache((char*)flushBegin, (char*)flushEnd);
+#endif
+}
+
+} // namespace glacie::memory
\ No newline at end of file
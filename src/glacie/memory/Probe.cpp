@@ -0,0 +1,355 @@
+#include "glacie/memory/Probe.h"
+#include "glacie/memory/Epoch.h"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <sys/mman.h>
+#endif
+
+namespace glacie::memory {
+
+namespace {
+
+constexpr size_t PROBE_CHUNK_SIZE  = 64;
+constexpr size_t PROBE_CHUNK_COUNT = 64;
+constexpr int    MAX_PROBE_COUNT   = PROBE_CHUNK_SIZE * PROBE_CHUNK_COUNT;
+
+struct ProbeCounter {
+    std::atomic_uint64_t calls{};
+    std::atomic_uint64_t totalTicks{};
+    std::atomic_uint64_t minTicks{UINT64_MAX};
+    std::atomic_uint64_t maxTicks{};
+
+    void reset() {
+        calls.store(0, std::memory_order_relaxed);
+        totalTicks.store(0, std::memory_order_relaxed);
+        minTicks.store(UINT64_MAX, std::memory_order_relaxed);
+        maxTicks.store(0, std::memory_order_relaxed);
+    }
+};
+
+// only the owning thread writes, so relaxed loads and stores are enough
+struct ProbeThreadData {
+    std::atomic<ProbeCounter*> chunks[PROBE_CHUNK_COUNT]{};
+    std::atomic_bool           inUse{};
+};
+
+struct ProbeFrame {
+    uintptr_t returnAddress;
+    int       id;
+    uint64_t  startTicks;
+};
+
+struct ProbeData {
+    int         id{};
+    std::string name{};
+    FuncPtr     target{};
+    FuncPtr     entry{};
+    size_t      entrySize{};
+    FuncPtr     original{};
+};
+
+class CodeBuffer {
+public:
+    CodeBuffer& emit(std::initializer_list<uint8_t> bytes) {
+        code.insert(code.end(), bytes);
+        return *this;
+    }
+
+    template <class T>
+    CodeBuffer& emit(T value) {
+        auto begin = reinterpret_cast<uint8_t const*>(&value);
+        code.insert(code.end(), begin, begin + sizeof(T));
+        return *this;
+    }
+
+    // movdqu [rsp+disp32], xmm
+    CodeBuffer& storeXmm(uint8_t xmm, int32_t disp) {
+        return emit({0xF3, 0x0F, 0x7F, uint8_t(0x84 | xmm << 3), 0x24}).emit(disp);
+    }
+
+    // movdqu xmm, [rsp+disp32]
+    CodeBuffer& loadXmm(uint8_t xmm, int32_t disp) {
+        return emit({0xF3, 0x0F, 0x6F, uint8_t(0x84 | xmm << 3), 0x24}).emit(disp);
+    }
+
+    // sub rsp, imm32
+    CodeBuffer& subRsp(int32_t value) { return emit({0x48, 0x81, 0xEC}).emit(value); }
+
+    // add rsp, imm32
+    CodeBuffer& addRsp(int32_t value) { return emit({0x48, 0x81, 0xC4}).emit(value); }
+
+    // mov rax, imm64; call rax
+    CodeBuffer& callAbsolute(void const* func) { return emit({0x48, 0xB8}).emit(func).emit({0xFF, 0xD0}); }
+
+    std::vector<uint8_t> code;
+};
+
+FuncPtr allocateCode(std::vector<uint8_t> const& code) {
+#ifdef _WIN32
+    auto memory = VirtualAlloc(nullptr, code.size(), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!memory) { return nullptr; }
+    memcpy(memory, code.data(), code.size());
+    DWORD dummy;
+    VirtualProtect(memory, code.size(), PAGE_EXECUTE_READ, &dummy);
+    FlushInstructionCache(GetCurrentProcess(), memory, code.size());
+#else
+    auto memory = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) { return nullptr; }
+    memcpy(memory, code.data(), code.size());
+    mprotect(memory, code.size(), PROT_READ | PROT_EXEC);
+    __builtin___clear_cache((char*)memory, (char*)memory + code.size());
+#endif
+    return memory;
+}
+
+} // namespace
+
+struct ProbeRegistry {
+    std::mutex                                              mutex;
+    std::unordered_map<int, std::unique_ptr<ProbeData>>     probes;
+    std::unordered_map<FuncPtr, std::unique_ptr<ProbeData>> removed; // by target, kept for good
+    int                                                     nextId{};
+    std::mutex                                              threadsMutex;
+    std::vector<std::unique_ptr<ProbeThreadData>>           threads;
+};
+
+ProbeRegistry& getProbeRegistry() {
+    // never destroyed, threads may still release their data after exit
+    static auto& registry = *new ProbeRegistry;
+    return registry;
+}
+
+static ProbeThreadData& getProbeThreadData() {
+    struct DataOwner {
+        ProbeThreadData* data{};
+        ~DataOwner() {
+            if (data) { data->inUse.store(false, std::memory_order_release); }
+        }
+    };
+    static thread_local DataOwner owner;
+    if (owner.data) [[likely]] { return *owner.data; }
+
+    auto&           registry = getProbeRegistry();
+    std::lock_guard lock(registry.threadsMutex);
+    // the aggregates of an exited thread are kept and continued by a new one
+    for (auto& item : registry.threads) {
+        if (!item->inUse.load(std::memory_order_acquire)) {
+            owner.data = item.get();
+            break;
+        }
+    }
+    if (!owner.data) { owner.data = registry.threads.emplace_back(std::make_unique<ProbeThreadData>()).get(); }
+    owner.data->inUse.store(true, std::memory_order_relaxed);
+    return *owner.data;
+}
+
+static thread_local std::vector<ProbeFrame> probeFrames;
+
+static FuncPtr getProbeExitStub();
+
+static void probeEnter(uint64_t id, uintptr_t* returnSlot) {
+    probeFrames.push_back({*returnSlot, (int)id, __rdtsc()});
+    *returnSlot = (uintptr_t)getProbeExitStub();
+}
+
+static uintptr_t probeExit() {
+    auto ticks = __rdtsc();
+    auto frame = probeFrames.back();
+    probeFrames.pop_back();
+    ticks -= frame.startTicks;
+
+    auto& data  = getProbeThreadData();
+    auto& slot  = data.chunks[frame.id / PROBE_CHUNK_SIZE];
+    auto  chunk = slot.load(std::memory_order_acquire);
+    if (!chunk) [[unlikely]] {
+        chunk = new ProbeCounter[PROBE_CHUNK_SIZE];
+        slot.store(chunk, std::memory_order_release);
+    }
+    auto& counter = chunk[frame.id % PROBE_CHUNK_SIZE];
+    counter.calls.store(counter.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    counter.totalTicks.store(counter.totalTicks.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+    if (ticks < counter.minTicks.load(std::memory_order_relaxed)) {
+        counter.minTicks.store(ticks, std::memory_order_relaxed);
+    }
+    if (ticks > counter.maxTicks.load(std::memory_order_relaxed)) {
+        counter.maxTicks.store(ticks, std::memory_order_relaxed);
+    }
+    return frame.returnAddress;
+}
+
+// the probed function returns here, the real return address is taken from the frame of the thread
+static FuncPtr getProbeExitStub() {
+    static FuncPtr stub = [] {
+        CodeBuffer buf;
+        buf.subRsp(8);                        // slot for the real return address
+        buf.emit({0x50, 0x52});               // push rax; push rdx
+        buf.subRsp(0x48);                     // shadow space, xmm0, xmm1, keeps rsp 16 byte aligned
+        buf.storeXmm(0, 0x20).storeXmm(1, 0x30);
+        buf.callAbsolute((void const*)&probeExit);
+        buf.emit({0x48, 0x89, 0x84, 0x24}).emit<int32_t>(0x58); // mov [rsp+0x58], rax
+        buf.loadXmm(0, 0x20).loadXmm(1, 0x30);
+        buf.addRsp(0x48);
+        buf.emit({0x5A, 0x58, 0xC3}); // pop rdx; pop rax; ret
+        return allocateCode(buf.code);
+    }();
+    return stub;
+}
+
+static std::vector<uint8_t> createProbeEntryStub(ProbeData const& probe) {
+    CodeBuffer buf;
+#ifdef _WIN32
+    // rcx, rdx, r8, r9 and xmm0-xmm3 hold the arguments, rax, r10, r11, xmm4 and xmm5 are volatile as well
+    buf.emit({0x51, 0x52, 0x41, 0x50, 0x41, 0x51, 0x50, 0x41, 0x52, 0x41, 0x53});
+    buf.subRsp(0x80);
+    for (uint8_t i = 0; i < 6; ++i) buf.storeXmm(i, 0x20 + i * 16);
+    buf.emit({0x48, 0xB9}).emit<uint64_t>(probe.id);                // mov rcx, id
+    buf.emit({0x48, 0x8D, 0x94, 0x24}).emit<int32_t>(0x80 + 7 * 8); // lea rdx, [rsp+return address]
+    buf.callAbsolute((void const*)&probeEnter);
+    for (uint8_t i = 0; i < 6; ++i) buf.loadXmm(i, 0x20 + i * 16);
+    buf.addRsp(0x80);
+    buf.emit({0x41, 0x5B, 0x41, 0x5A, 0x58, 0x41, 0x59, 0x41, 0x58, 0x5A, 0x59});
+#else
+    // rdi, rsi, rdx, rcx, r8, r9, rax and xmm0-xmm7 hold the arguments, r10 and r11 are volatile as well
+    buf.emit({0x57, 0x56, 0x52, 0x51, 0x41, 0x50, 0x41, 0x51, 0x50, 0x41, 0x52, 0x41, 0x53});
+    buf.subRsp(0x80);
+    for (uint8_t i = 0; i < 8; ++i) buf.storeXmm(i, i * 16);
+    buf.emit({0x48, 0xBF}).emit<uint64_t>(probe.id);                // mov rdi, id
+    buf.emit({0x48, 0x8D, 0xB4, 0x24}).emit<int32_t>(0x80 + 9 * 8); // lea rsi, [rsp+return address]
+    buf.callAbsolute((void const*)&probeEnter);
+    for (uint8_t i = 0; i < 8; ++i) buf.loadXmm(i, i * 16);
+    buf.addRsp(0x80);
+    buf.emit({0x41, 0x5B, 0x41, 0x5A, 0x58, 0x41, 0x59, 0x41, 0x58, 0x59, 0x5A, 0x5E, 0x5F});
+#endif
+    buf.emit({0x49, 0xBB}).emit(&probe.original); // mov r11, &original
+    buf.emit({0x41, 0xFF, 0x23});                 // jmp [r11]
+    return std::move(buf.code);
+}
+
+int addProbe(FuncPtr target, std::string_view name) {
+    if (target == nullptr || getProbeExitStub() == nullptr) { return -1; }
+    auto&           registry = getProbeRegistry();
+    std::lock_guard lock(registry.mutex);
+    for (auto& [id, probe] : registry.probes) {
+        if (probe->target == target) { return -1; }
+    }
+    // a function which was probed before gets its id and stub back, see removeProbe
+    std::unique_ptr<ProbeData> probe;
+    if (auto it = registry.removed.find(target); it != registry.removed.end()) {
+        probe       = std::move(it->second);
+        probe->name = name;
+        registry.removed.erase(it);
+    } else if (registry.nextId < MAX_PROBE_COUNT) {
+        probe            = std::make_unique<ProbeData>(ProbeData{registry.nextId, std::string{name}, target});
+        auto code        = createProbeEntryStub(*probe);
+        probe->entry     = allocateCode(code);
+        probe->entrySize = code.size();
+        if (!probe->entry) { return -1; }
+        ++registry.nextId;
+    } else {
+        return -1;
+    }
+    auto id = probe->id;
+    if (hook(target, probe->entry, &probe->original) != 0) {
+        registry.removed.emplace(target, std::move(probe));
+        return -1;
+    }
+    {
+        // the id may have belonged to an earlier probe of the function
+        std::lock_guard threadsLock(registry.threadsMutex);
+        for (auto& data : registry.threads) {
+            if (auto chunk = data->chunks[id / PROBE_CHUNK_SIZE].load(std::memory_order_acquire)) {
+                chunk[id % PROBE_CHUNK_SIZE].reset();
+            }
+        }
+    }
+    registry.probes.emplace(id, std::move(probe));
+    return id;
+}
+
+int addProbe(char const* identifier) { return addProbe(resolveIdentifier(identifier), identifier); }
+
+std::vector<int> addProbes(std::span<char const* const> identifiers) {
+    std::vector<int> result;
+    result.reserve(identifiers.size());
+    for (auto identifier : identifiers) result.push_back(addProbe(identifier));
+    return result;
+}
+
+bool removeProbe(int id) {
+    auto& registry = getProbeRegistry();
+    {
+        std::lock_guard lock(registry.mutex);
+        auto            it = registry.probes.find(id);
+        if (it == registry.probes.end()) { return false; }
+        if (!unhook(it->second->target, it->second->entry)) { return false; }
+        // the stub takes no epoch guard and a thread may still be on its way into it, so the stub is never
+        // released and its id is never given to another function, whose statistics it would otherwise reach
+        auto target = it->second->target;
+        registry.removed.emplace(target, std::move(it->second));
+        registry.probes.erase(it);
+    }
+    reclaim();
+    return true;
+}
+
+void removeAllProbes() {
+    std::vector<int> ids;
+    {
+        auto&           registry = getProbeRegistry();
+        std::lock_guard lock(registry.mutex);
+        for (auto& [id, probe] : registry.probes) ids.push_back(id);
+    }
+    for (auto id : ids) removeProbe(id);
+}
+
+std::vector<ProbeStats> getProbeStats() {
+    auto&                   registry = getProbeRegistry();
+    std::vector<ProbeStats> result;
+    std::lock_guard         lock(registry.mutex);
+    std::lock_guard         threadsLock(registry.threadsMutex);
+    for (auto& [id, probe] : registry.probes) {
+        ProbeStats stats{id, probe->name, probe->target, 0, 0, UINT64_MAX, 0};
+        for (auto& data : registry.threads) {
+            auto chunk = data->chunks[id / PROBE_CHUNK_SIZE].load(std::memory_order_acquire);
+            if (!chunk) { continue; }
+            auto& counter     = chunk[id % PROBE_CHUNK_SIZE];
+            stats.calls      += counter.calls.load(std::memory_order_relaxed);
+            stats.totalTicks += counter.totalTicks.load(std::memory_order_relaxed);
+            stats.minTicks    = std::min(stats.minTicks, counter.minTicks.load(std::memory_order_relaxed));
+            stats.maxTicks    = std::max(stats.maxTicks, counter.maxTicks.load(std::memory_order_relaxed));
+        }
+        if (stats.calls == 0) { stats.minTicks = 0; }
+        result.push_back(std::move(stats));
+    }
+    return result;
+}
+
+void resetProbeStats() {
+    auto&           registry = getProbeRegistry();
+    std::lock_guard lock(registry.threadsMutex);
+    for (auto& data : registry.threads) {
+        for (auto& slot : data->chunks) {
+            auto chunk = slot.load(std::memory_order_acquire);
+            if (!chunk) { continue; }
+            for (size_t i = 0; i < PROBE_CHUNK_SIZE; ++i) chunk[i].reset();
+        }
+    }
+}
+
+} // namespace glacie::memory
\ No newline at end of file
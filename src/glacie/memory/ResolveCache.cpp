@@ -0,0 +1,114 @@
+#include "glacie/memory/ResolveCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+namespace glacie::memory {
+
+struct ResolveCacheEntry {
+    std::string key{};
+    FuncPtr     result{};
+};
+
+struct ResolveCache {
+    std::unordered_map<uint64_t, ResolveCacheEntry> entries;
+    std::shared_mutex                               mutex;
+    std::atomic_size_t                              hits{};
+    std::atomic_size_t                              misses{};
+};
+
+ResolveCache& getResolveCache() {
+    static ResolveCache cache;
+    return cache;
+}
+
+static char normalizeModuleChar(char c) {
+#ifdef _WIN32
+    return c >= 'A' && c <= 'Z' ? (char)(c - 'A' + 'a') : c;
+#else
+    return c;
+#endif
+}
+
+std::string normalizeModuleName(std::string_view name) {
+    std::string result(name.size(), '\0');
+    std::transform(name.begin(), name.end(), result.begin(), normalizeModuleChar);
+    return result;
+}
+
+// the module is normalized on the fly, so a lookup does not allocate
+static uint64_t getCacheHash(std::string_view module, std::string_view identifier) {
+    uint64_t seed = 0xcbf29ce484222325;
+    for (char c : module) {
+        auto normalized = normalizeModuleChar(c);
+        seed            = hashIdentifier({&normalized, 1}, seed);
+    }
+    return hashIdentifier(identifier, seed);
+}
+
+static bool hasModulePrefix(std::string const& key, std::string_view module) {
+    return key.size() > module.size() && key[module.size()] == '\0'
+        && std::equal(module.begin(), module.end(), key.begin(), [](char a, char b) {
+               return normalizeModuleChar(a) == b;
+           });
+}
+
+// entries are keyed by hash, the full key with the normalized module is kept to reject collisions
+static bool isSameKey(std::string const& key, std::string_view module, std::string_view identifier) {
+    return key.size() == module.size() + 1 + identifier.size() && hasModulePrefix(key, module)
+        && key.ends_with(identifier);
+}
+
+bool findResolveCache(std::string_view module, std::string_view identifier, FuncPtr& result) {
+    auto&            cache = getResolveCache();
+    auto             hash  = getCacheHash(module, identifier);
+    std::shared_lock lock(cache.mutex);
+    auto             it = cache.entries.find(hash);
+    if (it == cache.entries.end() || !isSameKey(it->second.key, module, identifier)) {
+        cache.misses.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    cache.hits.fetch_add(1, std::memory_order_relaxed);
+    result = it->second.result;
+    return true;
+}
+
+void insertResolveCache(std::string_view module, std::string_view identifier, FuncPtr result) {
+    auto&       cache = getResolveCache();
+    std::string key;
+    key.reserve(module.size() + 1 + identifier.size());
+    key.append(normalizeModuleName(module)).push_back('\0');
+    key.append(identifier);
+    std::unique_lock lock(cache.mutex);
+    cache.entries.try_emplace(getCacheHash(module, identifier), ResolveCacheEntry{std::move(key), result});
+}
+
+ResolveCacheStats getResolveCacheStats() {
+    auto&            cache = getResolveCache();
+    std::shared_lock lock(cache.mutex);
+    return {
+        cache.hits.load(std::memory_order_relaxed),
+        cache.misses.load(std::memory_order_relaxed),
+        cache.entries.size()
+    };
+}
+
+void eraseResolveCache(std::string_view module) {
+    auto&            cache = getResolveCache();
+    std::unique_lock lock(cache.mutex);
+    std::erase_if(cache.entries, [&](auto const& item) { return hasModulePrefix(item.second.key, module); });
+}
+
+void clearResolveCache() {
+    auto&            cache = getResolveCache();
+    std::unique_lock lock(cache.mutex);
+    cache.entries.clear();
+    cache.hits   = 0;
+    cache.misses = 0;
+}
+
+} // namespace glacie::memory
\ No newline at end of file
@@ -0,0 +1,413 @@
+#include "glacie/memory/SymbolIndex.h"
+#include "glacie/memory/Memory.h"
+#include "glacie/memory/ResolveCache.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string_view>
+
+#include "glacie/utils/StringUtils.h"
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <link.h>
+#endif
+
+namespace glacie::memory {
+
+namespace {
+
+constexpr char     INDEX_MAGIC[8] = {'G', 'L', 'S', 'Y', 'M', 'I', 'D', 'X'};
+constexpr uint32_t INDEX_VERSION  = 1;
+
+struct IndexHeader {
+    char     magic[8];
+    uint32_t version;
+    uint32_t count;
+    uint64_t slotCount;
+};
+
+struct IndexSlot {
+    uint64_t hash;
+    uint64_t rva;
+    uint32_t nameOffset;
+    uint32_t nameSize; // 0 for an empty slot
+};
+
+// ELF64 structures, declared here so that images can be read on every platform
+struct ElfHeader {
+    uint8_t  ident[16];
+    uint16_t type;
+    uint16_t machine;
+    uint32_t version;
+    uint64_t entry;
+    uint64_t phoff;
+    uint64_t shoff;
+    uint32_t flags;
+    uint16_t ehsize;
+    uint16_t phentsize;
+    uint16_t phnum;
+    uint16_t shentsize;
+    uint16_t shnum;
+    uint16_t shstrndx;
+};
+
+struct ElfSection {
+    uint32_t name;
+    uint32_t type;
+    uint64_t flags;
+    uint64_t addr;
+    uint64_t offset;
+    uint64_t size;
+    uint32_t link;
+    uint32_t info;
+    uint64_t addralign;
+    uint64_t entsize;
+};
+
+struct ElfSymbol {
+    uint32_t name;
+    uint8_t  info;
+    uint8_t  other;
+    uint16_t shndx;
+    uint64_t value;
+    uint64_t size;
+};
+
+constexpr uint8_t  ELF_MAGIC[4]        = {0x7F, 'E', 'L', 'F'};
+constexpr uint32_t ELF_SECTION_SYMTAB  = 2;
+constexpr uint32_t ELF_SECTION_DYNSYM  = 11;
+constexpr uint16_t ELF_INDEX_RESERVED  = 0xFF00; // SHN_ABS, SHN_COMMON and others which are no section
+constexpr uint16_t ELF_INDEX_EXTENDED  = 0xFFFF; // the section index is kept in SHT_SYMTAB_SHNDX
+constexpr uint8_t  ELF_SYMBOL_TYPE_TLS = 6;
+
+} // namespace
+
+std::vector<uint8_t> SymbolIndex::build(std::span<SymbolEntry const> entries) {
+    uint64_t slotCount = std::bit_ceil(std::max<uint64_t>(entries.size() * 2, 16));
+    size_t   namesSize = 0;
+    for (auto& entry : entries) namesSize += entry.name.size();
+
+    std::vector<uint8_t> result(sizeof(IndexHeader) + slotCount * sizeof(IndexSlot) + namesSize);
+    auto                 header = reinterpret_cast<IndexHeader*>(result.data());
+    auto                 slots  = reinterpret_cast<IndexSlot*>(result.data() + sizeof(IndexHeader));
+    auto                 names  = reinterpret_cast<char*>(slots + slotCount);
+    memcpy(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    header->version   = INDEX_VERSION;
+    header->slotCount = slotCount;
+
+    uint32_t count      = 0;
+    uint32_t nameOffset = 0;
+    for (auto& entry : entries) {
+        if (entry.name.empty()) { continue; }
+        auto hash = hashIdentifier(entry.name);
+        auto slot = hash & (slotCount - 1);
+        bool dup  = false;
+        for (; slots[slot].nameSize != 0; slot = (slot + 1) & (slotCount - 1)) {
+            if (slots[slot].hash == hash
+                && std::string_view{names + slots[slot].nameOffset, slots[slot].nameSize} == entry.name) {
+                dup = true;
+                break;
+            }
+        }
+        if (dup) { continue; }
+        slots[slot] = {hash, entry.rva, nameOffset, (uint32_t)entry.name.size()};
+        memcpy(names + nameOffset, entry.name.data(), entry.name.size());
+        nameOffset += (uint32_t)entry.name.size();
+        ++count;
+    }
+    header->count = count;
+    result.resize(sizeof(IndexHeader) + slotCount * sizeof(IndexSlot) + nameOffset);
+    return result;
+}
+
+std::vector<SymbolEntry> SymbolIndex::readMapFile(std::string const& path) {
+    std::vector<SymbolEntry>      result;
+    utils::file_utils::MappedFile file(path);
+    if (!file.isOpen()) { return result; }
+    std::string_view content{(char const*)file.getData().data(), file.getData().size()};
+
+    constexpr std::string_view BASE_PREFIX = "Preferred load address is ";
+    auto                       basePos     = content.find(BASE_PREFIX);
+    if (basePos == std::string_view::npos) { return result; }
+    uint64_t base = strtoull(content.data() + basePos + BASE_PREFIX.size(), nullptr, 16);
+
+    // " 0001:00000000       ?foo@@YAXXZ                0000000140001000 f   foo.obj"
+    for (size_t pos = basePos, next; pos < content.size(); pos = next + 1) {
+        next = content.find('\n', pos);
+        if (next == std::string_view::npos) { next = content.size(); }
+        auto line   = content.substr(pos, next - pos);
+        auto tokens = utils::string_utils::splitByPattern(line, " ");
+        if (tokens.size() < 3 || tokens[0].size() != 13 || tokens[0][4] != ':') { continue; }
+        auto     address = tokens[2];
+        uint64_t va      = 0;
+        bool     isHex   = address.size() == 16;
+        for (char c : address) {
+            auto digit = utils::string_utils::digitFromChar(c);
+            if (digit >= 16) {
+                isHex = false;
+                break;
+            }
+            va = va << 4 | digit;
+        }
+        if (!isHex || va < base) { continue; }
+        result.push_back({std::string{tokens[1]}, va - base});
+    }
+    return result;
+}
+
+std::vector<SymbolEntry> SymbolIndex::readElfSymbols(std::string const& path) {
+    std::vector<SymbolEntry>      result;
+    utils::file_utils::MappedFile file(path);
+    if (!file.isOpen()) { return result; }
+    auto data = file.getData();
+    if (data.size() < sizeof(ElfHeader) || memcmp(data.data(), ELF_MAGIC, sizeof(ELF_MAGIC)) != 0) {
+        return result;
+    }
+    ElfHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+    if (header.ident[4] != 2 || header.shentsize != sizeof(ElfSection)
+        || header.shoff + (uint64_t)header.shnum * sizeof(ElfSection) > data.size()) {
+        return result;
+    }
+    auto sections = reinterpret_cast<ElfSection const*>(data.data() + header.shoff);
+    for (uint16_t i = 0; i < header.shnum; ++i) {
+        auto& section = sections[i];
+        if (section.type != ELF_SECTION_SYMTAB && section.type != ELF_SECTION_DYNSYM) { continue; }
+        if (section.link >= header.shnum || section.offset + section.size > data.size()) { continue; }
+        auto& strtab = sections[section.link];
+        if (strtab.offset + strtab.size > data.size()) { continue; }
+        auto symbols = reinterpret_cast<ElfSymbol const*>(data.data() + section.offset);
+        auto strings = reinterpret_cast<char const*>(data.data() + strtab.offset);
+        for (size_t j = 0; j < section.size / sizeof(ElfSymbol); ++j) {
+            auto& symbol = symbols[j];
+            // absolute symbols and thread-local offsets are no addresses inside the image
+            if (symbol.shndx == 0 || (symbol.shndx >= ELF_INDEX_RESERVED && symbol.shndx != ELF_INDEX_EXTENDED)
+                || (symbol.info & 0xF) == ELF_SYMBOL_TYPE_TLS || symbol.value == 0 || symbol.name >= strtab.size) {
+                continue;
+            }
+            auto name = strings + symbol.name;
+            result.push_back({std::string{name, strnlen(name, strtab.size - symbol.name)}, symbol.value});
+        }
+    }
+    return result;
+}
+
+bool SymbolIndex::attach(std::span<uint8_t const> data) {
+    if (data.size() < sizeof(IndexHeader)) { return false; }
+    auto header = reinterpret_cast<IndexHeader const*>(data.data());
+    if (memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0 || header->version != INDEX_VERSION
+        || !std::has_single_bit(header->slotCount) || header->count >= header->slotCount
+        || header->slotCount > (data.size() - sizeof(IndexHeader)) / sizeof(IndexSlot)) {
+        return false;
+    }
+    view = data;
+    return true;
+}
+
+bool SymbolIndex::open(std::string const& path) {
+    close();
+    if (!file.open(path)) { return false; }
+    if (!attach(file.getData())) {
+        file.close();
+        return false;
+    }
+    return true;
+}
+
+bool SymbolIndex::load(std::vector<uint8_t> index) {
+    close();
+    owned = std::move(index);
+    if (!attach(owned)) {
+        owned.clear();
+        return false;
+    }
+    return true;
+}
+
+void SymbolIndex::close() {
+    view = {};
+    file.close();
+    owned.clear();
+}
+
+size_t SymbolIndex::size() const noexcept {
+    if (view.empty()) { return 0; }
+    return reinterpret_cast<IndexHeader const*>(view.data())->count;
+}
+
+std::optional<uint64_t> SymbolIndex::find(std::string_view name) const {
+    if (view.empty() || name.empty()) { return std::nullopt; }
+    auto header    = reinterpret_cast<IndexHeader const*>(view.data());
+    auto slots     = reinterpret_cast<IndexSlot const*>(view.data() + sizeof(IndexHeader));
+    auto names     = reinterpret_cast<char const*>(slots + header->slotCount);
+    auto namesSize = view.size() - sizeof(IndexHeader) - header->slotCount * sizeof(IndexSlot);
+    auto hash      = hashIdentifier(name);
+    // a corrupt index may have no empty slot, so the probing stops after one round
+    auto slot = hash & (header->slotCount - 1);
+    for (uint64_t probe = 0; probe < header->slotCount && slots[slot].nameSize != 0;
+         ++probe, slot = (slot + 1) & (header->slotCount - 1)) {
+        auto& entry = slots[slot];
+        if (entry.hash != hash || entry.nameSize != name.size()) { continue; }
+        if ((uint64_t)entry.nameOffset + entry.nameSize > namesSize) { return std::nullopt; }
+        if (std::string_view{names + entry.nameOffset, entry.nameSize} == name) { return entry.rva; }
+    }
+    return std::nullopt;
+}
+
+bool isSymbolIdentifier(std::string_view identifier) {
+    if (identifier.empty()) { return false; }
+    // a signature only consists of hex bytes and wildcards separated by spaces
+    for (auto token : utils::string_utils::splitByPattern(identifier, " ")) {
+        if (token == "?" || token == "??") { continue; }
+        if (token.size() != 2 || utils::string_utils::digitFromChar(token[0]) >= 16
+            || utils::string_utils::digitFromChar(token[1]) >= 16) {
+            return true;
+        }
+    }
+    return false;
+}
+
+struct ServerSymbolIndex {
+    std::mutex  mutex;
+    SymbolIndex index;
+    bool        initialized{};
+};
+
+ServerSymbolIndex& getServerSymbolIndex() {
+    static ServerSymbolIndex index;
+    return index;
+}
+
+#ifdef _WIN32
+static HMODULE getServerModule() {
+    return GetModuleHandleW(utils::string_utils::str2wstr(serverModuleName).c_str());
+}
+#endif
+
+std::filesystem::path getServerPath() {
+#ifdef _WIN32
+    wchar_t buf[MAX_PATH]{};
+    auto    len = GetModuleFileNameW(getServerModule(), buf, MAX_PATH);
+    return len ? std::filesystem::path{buf} : std::filesystem::path{};
+#else
+    std::error_code ec;
+    return std::filesystem::read_symlink("/proc/self/exe", ec);
+#endif
+}
+
+std::optional<uintptr_t> getServerBase() {
+#ifdef _WIN32
+    auto base = (uintptr_t)getServerModule();
+    if (!base) { return std::nullopt; }
+    return base;
+#else
+    uintptr_t base = 0;
+    // the first object is the main program
+    dl_iterate_phdr(
+        [](dl_phdr_info* info, size_t, void* data) {
+            *(uintptr_t*)data = (uintptr_t)info->dlpi_addr;
+            return 1;
+        },
+        &base
+    );
+    return base;
+#endif
+}
+
+static std::filesystem::path getIndexCacheDirectory() {
+#ifdef _WIN32
+    wchar_t buf[MAX_PATH]{};
+    auto    len = GetEnvironmentVariableW(L"LOCALAPPDATA", buf, MAX_PATH);
+    if (!len || len >= MAX_PATH) { return {}; }
+    return std::filesystem::path{buf} / "glacie";
+#else
+    if (auto dir = getenv("XDG_CACHE_HOME"); dir && *dir) { return std::filesystem::path{dir} / "glacie"; }
+    if (auto home = getenv("HOME"); home && *home) { return std::filesystem::path{home} / ".cache" / "glacie"; }
+    return {};
+#endif
+}
+
+// next to the server first, then in the cache directory of the user in case the server directory is read-only
+static std::vector<std::filesystem::path> getIndexPaths(std::filesystem::path const& serverPath) {
+    std::vector<std::filesystem::path> result{serverPath};
+    result[0].replace_extension(".symidx");
+    auto cacheDir = getIndexCacheDirectory();
+    if (cacheDir.empty()) { return result; }
+    // named after the full path, so servers in different directories do not share an index
+    auto hash = utils::string_utils::intToHexStr(hashIdentifier(serverPath.string()), false, true, false);
+    result.push_back(cacheDir / (serverPath.stem().string() + "-" + hash + ".symidx"));
+    return result;
+}
+
+// build the index once and reuse it until the server changes
+static void initServerSymbolIndex(SymbolIndex& index) {
+    auto serverPath = getServerPath();
+    if (serverPath.empty()) { return; }
+    auto indexPaths = getIndexPaths(serverPath);
+#ifdef _WIN32
+    auto sourcePath = serverPath;
+    sourcePath.replace_extension(".map");
+#else
+    auto const& sourcePath = serverPath;
+#endif
+    std::error_code ec;
+    auto            sourceTime = std::filesystem::last_write_time(sourcePath, ec);
+    if (ec) {
+        // nothing to build from, use a shipped index if there is one
+        for (auto& indexPath : indexPaths) {
+            if (index.open(indexPath.string())) { return; }
+        }
+        return;
+    }
+    for (auto& indexPath : indexPaths) {
+        auto indexTime = std::filesystem::last_write_time(indexPath, ec);
+        if (!ec && indexTime >= sourceTime && index.open(indexPath.string())) { return; }
+    }
+
+#ifdef _WIN32
+    auto entries = SymbolIndex::readMapFile(sourcePath.string());
+#else
+    auto entries = SymbolIndex::readElfSymbols(sourcePath.string());
+#endif
+    auto data = SymbolIndex::build(entries);
+    for (auto& indexPath : indexPaths) {
+        std::filesystem::create_directories(indexPath.parent_path(), ec);
+        if (utils::file_utils::writeFile(indexPath.string(), data) && index.open(indexPath.string())) { return; }
+    }
+    // no directory is writable, the index only lives in memory
+    index.load(std::move(data));
+}
+
+bool loadSymbolIndex(std::string const& path) {
+    auto&           server = getServerSymbolIndex();
+    std::lock_guard lock(server.mutex);
+    server.initialized = true;
+    if (!server.index.open(path)) { return false; }
+    // drop results resolved without this index
+    clearResolveCache();
+    return true;
+}
+
+FuncPtr resolveSymbol(char const* symbol) {
+    return resolveCached(serverModuleName, symbol, [&]() -> FuncPtr {
+        auto&           server = getServerSymbolIndex();
+        std::lock_guard lock(server.mutex);
+        if (!server.initialized) {
+            server.initialized = true;
+            initServerSymbolIndex(server.index);
+        }
+        auto rva = server.index.find(symbol);
+        if (!rva) { return nullptr; }
+        auto base = getServerBase();
+        if (!base) { return nullptr; }
+        return reinterpret_cast<FuncPtr>(*base + *rva);
+    });
+}
+
+} // namespace glacie::memory
\ No newline at end of file
@@ -0,0 +1,226 @@
+#include "glacie/memory/Timeline.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+
+#include "glacie/utils/FileUtils.h"
+#include "glacie/utils/StringUtils.h"
+
+#include "fmt/format.h"
+
+#ifdef _WIN32
+#include "windows.h"
+#endif
+
+namespace glacie::memory {
+
+struct TimelineState {
+    std::atomic_bool                      active{};
+    std::mutex                            mutex;
+    std::chrono::steady_clock::time_point origin{std::chrono::steady_clock::now()};
+    std::vector<TimelineEvent>            events;
+};
+
+TimelineState& getTimelineState() {
+    // events may be recorded by static destructors
+    static auto& state = *new TimelineState;
+    return state;
+}
+
+static thread_local TimelineScope* currentTimelineScope{};
+
+static uint32_t getTimelineThreadId() {
+    static std::atomic_uint32_t  nextId{};
+    static thread_local uint32_t threadId = ++nextId;
+    return threadId;
+}
+
+static uint64_t getTimelineNs(TimelineState& state) {
+    auto elapsed = std::chrono::steady_clock::now() - state.origin;
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+static bool isTimelineRequested() {
+#ifdef _WIN32
+    char value[8]{};
+    if (!GetEnvironmentVariableA("GLACIE_TIMELINE", value, sizeof(value))) { return false; }
+#else
+    auto value = getenv("GLACIE_TIMELINE");
+    if (!value) { return false; }
+#endif
+    return value[0] && value[0] != '0';
+}
+
+std::string_view getTimelineEventKindName(TimelineEventKind kind) noexcept {
+    switch (kind) {
+    case TimelineEventKind::ResolveSignature: return "resolveSignature";
+    case TimelineEventKind::ResolveIdentifier: return "resolveIdentifier";
+    case TimelineEventKind::Hook: return "hook";
+    case TimelineEventKind::ProcessHook: return "processHook";
+    case TimelineEventKind::HookRegistrar: return "HookRegistrar";
+    case TimelineEventKind::PatchCommit: return "PatchBatch::commit";
+    }
+    return "unknown";
+}
+
+void startTimeline() { getTimelineState().active.store(true, std::memory_order_relaxed); }
+
+void stopTimeline() { getTimelineState().active.store(false, std::memory_order_relaxed); }
+
+bool isTimelineActive() noexcept {
+    // hooks registered by static initializers may come before any call to startTimeline
+    [[maybe_unused]] static bool const requested = isTimelineRequested() && (startTimeline(), true);
+    return getTimelineState().active.load(std::memory_order_relaxed);
+}
+
+void clearTimeline() {
+    auto&           state = getTimelineState();
+    std::lock_guard lock(state.mutex);
+    state.events.clear();
+}
+
+std::vector<TimelineEvent> getTimelineEvents() {
+    auto&           state = getTimelineState();
+    std::lock_guard lock(state.mutex);
+    return state.events;
+}
+
+std::vector<TimelineEvent> getSlowestTimelineEvents(TimelineEventKind kind, size_t count) {
+    std::vector<TimelineEvent> result;
+    for (auto& event : getTimelineEvents()) {
+        if (event.kind == kind) { result.push_back(std::move(event)); }
+    }
+    count = std::min(count, result.size());
+    std::partial_sort(result.begin(), result.begin() + count, result.end(), [](auto const& a, auto const& b) {
+        return a.durationNs > b.durationNs;
+    });
+    result.resize(count);
+    return result;
+}
+
+std::vector<TimelineSummary> getTimelineSummary() {
+    std::array<TimelineSummary, timelineEventKindCount> summaries{};
+    for (auto& event : getTimelineEvents()) {
+        auto& summary      = summaries[(size_t)event.kind];
+        summary.kind       = event.kind;
+        summary.count     += 1;
+        summary.cacheHits += event.cacheHit ? 1 : 0;
+        summary.totalNs   += event.durationNs;
+        summary.maxNs      = std::max(summary.maxNs, event.durationNs);
+        summary.bytes     += event.bytes;
+    }
+    std::vector<TimelineSummary> result;
+    for (auto& summary : summaries) {
+        if (summary.count) { result.push_back(summary); }
+    }
+    return result;
+}
+
+static std::string escapeJson(std::string_view str) {
+    static utils::string_utils::MultiReplacer const replacer{{"\\", "\\\\"}, {"\"", "\\\""}, {"\n", "\\n"}};
+    return replacer(str);
+}
+
+static bool writeJson(std::string const& path, fmt::memory_buffer const& out) {
+    return utils::file_utils::writeFile(path, {(uint8_t const*)out.data(), out.size()});
+}
+
+bool writeTimelineChromeTrace(std::string const& path) {
+    auto events = getTimelineEvents();
+    auto out    = fmt::memory_buffer();
+    fmt::format_to(std::back_inserter(out), R"({{"displayTimeUnit":"ns","traceEvents":[)");
+    for (size_t i = 0; i < events.size(); ++i) {
+        auto& event = events[i];
+        fmt::format_to(
+            std::back_inserter(out),
+            R"({}{{"name":"{}","cat":"{}","ph":"X","ts":{:.3f},"dur":{:.3f},"pid":0,"tid":{},)"
+            R"("args":{{"cacheHit":{},"bytes":{}}}}})",
+            i ? "," : "",
+            escapeJson(event.name),
+            getTimelineEventKindName(event.kind),
+            (double)event.startNs / 1e3,
+            (double)event.durationNs / 1e3,
+            event.threadId,
+            event.cacheHit,
+            event.bytes
+        );
+    }
+    fmt::format_to(std::back_inserter(out), "]}}");
+    return writeJson(path, out);
+}
+
+bool writeTimelineSummary(std::string const& path, size_t slowestCount) {
+    auto out = fmt::memory_buffer();
+    fmt::format_to(std::back_inserter(out), "{{");
+    bool first = true;
+    for (auto& summary : getTimelineSummary()) {
+        fmt::format_to(
+            std::back_inserter(out),
+            R"({}"{}":{{"count":{},"cacheHits":{},"totalNs":{},"maxNs":{},"bytes":{},"slowest":[)",
+            first ? "" : ",",
+            getTimelineEventKindName(summary.kind),
+            summary.count,
+            summary.cacheHits,
+            summary.totalNs,
+            summary.maxNs,
+            summary.bytes
+        );
+        first = false;
+        auto slowest = getSlowestTimelineEvents(summary.kind, slowestCount);
+        for (size_t i = 0; i < slowest.size(); ++i) {
+            fmt::format_to(
+                std::back_inserter(out),
+                R"({}{{"name":"{}","durationNs":{},"cacheHit":{},"bytes":{}}})",
+                i ? "," : "",
+                escapeJson(slowest[i].name),
+                slowest[i].durationNs,
+                slowest[i].cacheHit,
+                slowest[i].bytes
+            );
+        }
+        fmt::format_to(std::back_inserter(out), "]}}");
+    }
+    fmt::format_to(std::back_inserter(out), "}}");
+    return writeJson(path, out);
+}
+
+TimelineScope::TimelineScope(TimelineEventKind kind, std::string_view name) : kind(kind) {
+    open();
+    if (active) { this->name = name; }
+}
+
+TimelineScope::TimelineScope(TimelineEventKind kind, FuncPtr address) : kind(kind) {
+    open();
+    if (active) { name = fmt::format("{}", address); }
+}
+
+void TimelineScope::open() {
+    if (!isTimelineActive()) { return; }
+    if (currentTimelineScope && currentTimelineScope->kind == kind) {
+        owner = currentTimelineScope;
+        return;
+    }
+    active               = true;
+    parent               = currentTimelineScope;
+    currentTimelineScope = this;
+    startNs              = getTimelineNs(getTimelineState());
+}
+
+TimelineScope::~TimelineScope() {
+    if (!active) { return; }
+    currentTimelineScope = parent;
+    auto&           state = getTimelineState();
+    auto            endNs = getTimelineNs(state);
+    std::lock_guard lock(state.mutex);
+    state.events.push_back({kind, cacheHit, getTimelineThreadId(), startNs, endNs - startNs, bytes, std::move(name)});
+}
+
+void addTimelineBytes(uint64_t count) noexcept {
+    if (currentTimelineScope) { currentTimelineScope->addBytes(count); }
+}
+
+} // namespace glacie::memory
\ No newline at end of file
@@ -0,0 +1,370 @@
+#include "glacie/memory/Trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "glacie/utils/FileUtils.h"
+#include "glacie/utils/StringUtils.h"
+
+#include "fmt/format.h"
+
+#ifdef _WIN32
+#include "windows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace glacie::memory {
+
+namespace {
+
+constexpr char   TRACE_MAGIC[8]    = {'G', 'L', 'T', 'R', 'A', 'C', 'E', '1'};
+constexpr size_t TRACE_GROW_SIZE   = 16 * 1024 * 1024;
+constexpr auto   TRACE_DRAIN_DELAY = std::chrono::milliseconds(1);
+
+// a file which is written through a mapping that grows in large steps
+class MappedWriter {
+public:
+    bool open(std::string const& path) {
+#ifdef _WIN32
+        file = CreateFileW(
+            utils::string_utils::str2wstr(path).c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            FILE_SHARE_READ,
+            nullptr,
+            CREATE_ALWAYS,
+            FILE_ATTRIBUTE_NORMAL,
+            nullptr
+        );
+        if (file == INVALID_HANDLE_VALUE) {
+            file = nullptr;
+            return false;
+        }
+#else
+        file = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (file < 0) { return false; }
+#endif
+        size = 0;
+        return reserve(TRACE_GROW_SIZE);
+    }
+
+    // grow the mapping so that appending len more bytes cannot fail
+    bool ensure(size_t len) {
+        return size + len <= capacity || reserve(std::max(capacity + TRACE_GROW_SIZE, size + len));
+    }
+
+    bool append(void const* src, size_t len) {
+        if (!ensure(len)) { return false; }
+        memcpy(data + size, src, len);
+        size += len;
+        return true;
+    }
+
+    [[nodiscard]] uint8_t* at(size_t offset) const { return data + offset; }
+
+    [[nodiscard]] size_t getSize() const { return size; }
+
+    void close() {
+        unmap();
+#ifdef _WIN32
+        if (!file) { return; }
+        LARGE_INTEGER end;
+        end.QuadPart = (LONGLONG)size;
+        SetFilePointerEx(file, end, nullptr, FILE_BEGIN);
+        SetEndOfFile(file);
+        CloseHandle(file);
+        file = nullptr;
+#else
+        if (file < 0) { return; }
+        (void)ftruncate(file, (off_t)size);
+        ::close(file);
+        file = -1;
+#endif
+    }
+
+private:
+    uint8_t* data{};
+    size_t   size{};
+    size_t   capacity{};
+#ifdef _WIN32
+    HANDLE file{};
+    HANDLE mapping{};
+#else
+    int file{-1};
+#endif
+
+    void unmap() {
+        if (!data) { return; }
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+        CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        munmap(data, capacity);
+#endif
+        data     = nullptr;
+        capacity = 0;
+    }
+
+    bool reserve(size_t newCapacity) {
+        unmap();
+#ifdef _WIN32
+        mapping = CreateFileMappingW(
+            file,
+            nullptr,
+            PAGE_READWRITE,
+            (DWORD)(newCapacity >> 32),
+            (DWORD)newCapacity,
+            nullptr
+        );
+        if (!mapping) { return false; }
+        data = (uint8_t*)MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, newCapacity);
+        if (!data) {
+            CloseHandle(mapping);
+            mapping = nullptr;
+            return false;
+        }
+#else
+        if (ftruncate(file, (off_t)newCapacity) != 0) { return false; }
+        auto view = mmap(nullptr, newCapacity, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+        if (view == MAP_FAILED) { return false; }
+        data = (uint8_t*)view;
+#endif
+        capacity = newCapacity;
+        return true;
+    }
+};
+
+} // namespace
+
+struct TraceState {
+    std::mutex                                mutex;
+    std::vector<std::unique_ptr<TraceRing>>   rings;
+    std::unordered_map<std::string, uint32_t> sourceIds;
+    std::vector<std::string>                  sources;
+
+    std::mutex                            controlMutex;
+    std::thread                           drainer;
+    std::atomic_bool                      stopping{};
+    MappedWriter                          writer;
+    uint64_t                              startTicks{};
+    std::chrono::steady_clock::time_point startTime{};
+    uint64_t                              recordCount{};
+    bool                                  writeFailed{}; // records or names are missing from the file
+};
+
+TraceState& getTraceState() {
+    // never destroyed, threads may still release their rings after exit
+    static auto& state = *new TraceState;
+    return state;
+}
+
+static uint32_t getCurrentThreadId() {
+#ifdef _WIN32
+    return (uint32_t)GetCurrentThreadId();
+#else
+    return (uint32_t)syscall(SYS_gettid);
+#endif
+}
+
+TraceRing& registerTraceThread() {
+    struct RingOwner {
+        TraceRing* ring{};
+        ~RingOwner() {
+            if (!ring) { return; }
+            currentTraceRing = nullptr;
+            ring->inUse.store(false, std::memory_order_release);
+        }
+    };
+    static thread_local RingOwner owner;
+
+    auto&           state = getTraceState();
+    std::lock_guard lock(state.mutex);
+    TraceRing*      ring = nullptr;
+    // a ring is reused once its previous thread has exited and it has been drained
+    for (auto& item : state.rings) {
+        if (!item->inUse.load(std::memory_order_acquire)
+            && item->head.load(std::memory_order_relaxed) == item->tail.load(std::memory_order_relaxed)) {
+            ring = item.get();
+            break;
+        }
+    }
+    if (!ring) { ring = state.rings.emplace_back(std::make_unique<TraceRing>()).get(); }
+    ring->threadId = getCurrentThreadId();
+    ring->inUse.store(true, std::memory_order_relaxed);
+    owner.ring       = ring;
+    currentTraceRing = ring;
+    return *ring;
+}
+
+uint32_t registerTraceSource(std::string_view name) {
+    auto&           state = getTraceState();
+    std::lock_guard lock(state.mutex);
+    auto [it, inserted] = state.sourceIds.try_emplace(std::string{name}, (uint32_t)state.sources.size() + 1);
+    if (inserted) { state.sources.emplace_back(name); }
+    return it->second;
+}
+
+static void drainTraceRings(TraceState& state) {
+    std::vector<TraceRing*> rings;
+    {
+        std::lock_guard lock(state.mutex);
+        rings.reserve(state.rings.size());
+        for (auto& ring : state.rings) rings.push_back(ring.get());
+    }
+    for (auto ring : rings) {
+        auto tail = ring->tail.load(std::memory_order_relaxed);
+        auto head = ring->head.load(std::memory_order_acquire);
+        if (head == tail) { continue; }
+        auto begin = tail & (TraceRing::capacity - 1);
+        auto count = (size_t)(head - tail);
+        auto first = std::min(count, TraceRing::capacity - begin);
+        // both parts are written or none, so that the count of records matches the file
+        if (!state.writeFailed && state.writer.ensure(count * sizeof(TraceRecord))
+            && state.writer.append(ring->records + begin, first * sizeof(TraceRecord))
+            && state.writer.append(ring->records, (count - first) * sizeof(TraceRecord))) {
+            state.recordCount += count;
+        } else {
+            state.writeFailed = true;
+            ring->dropped.fetch_add(count, std::memory_order_relaxed);
+        }
+        ring->tail.store(head, std::memory_order_release);
+    }
+}
+
+bool startHookTrace(std::string const& path) {
+    auto&           state = getTraceState();
+    std::lock_guard control(state.controlMutex);
+    if (state.drainer.joinable()) { return false; }
+    if (!state.writer.open(path)) {
+        state.writer.close();
+        return false;
+    }
+    TraceFileHeader header{};
+    if (!state.writer.append(&header, sizeof(header))) {
+        state.writer.close();
+        return false;
+    }
+    {
+        // discard the records left over from a previous trace
+        std::lock_guard lock(state.mutex);
+        for (auto& ring : state.rings) {
+            ring->tail.store(ring->head.load(std::memory_order_acquire), std::memory_order_release);
+            ring->dropped.store(0, std::memory_order_relaxed);
+        }
+    }
+    state.recordCount = 0;
+    state.writeFailed = false;
+    state.startTime   = std::chrono::steady_clock::now();
+    state.startTicks  = __rdtsc();
+    state.stopping.store(false);
+    state.drainer = std::thread([&state] {
+        while (!state.stopping.load(std::memory_order_acquire)) {
+            drainTraceRings(state);
+            std::this_thread::sleep_for(TRACE_DRAIN_DELAY);
+        }
+    });
+    hookTraceActive.store(true, std::memory_order_release);
+    return true;
+}
+
+bool stopHookTrace() {
+    auto&           state = getTraceState();
+    std::lock_guard control(state.controlMutex);
+    if (!state.drainer.joinable()) { return false; }
+    hookTraceActive.store(false, std::memory_order_release);
+    state.stopping.store(true, std::memory_order_release);
+    state.drainer.join();
+    drainTraceRings(state);
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - state.startTime).count();
+    auto ticks   = __rdtsc() - state.startTicks;
+
+    TraceFileHeader header{};
+    memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.ticksPerSecond = elapsed > 0 ? (uint64_t)((double)ticks / elapsed) : 0;
+    header.startTicks     = state.startTicks;
+    header.recordCount    = state.recordCount;
+    header.namesOffset    = state.writer.getSize();
+    {
+        std::lock_guard lock(state.mutex);
+        for (auto& ring : state.rings) header.droppedCount += ring->dropped.load(std::memory_order_relaxed);
+        auto count        = (uint32_t)state.sources.size();
+        state.writeFailed = state.writeFailed || !state.writer.append(&count, sizeof(count));
+        for (uint32_t i = 0; i < count && !state.writeFailed; ++i) {
+            uint32_t entry[2] = {i + 1, (uint32_t)state.sources[i].size()};
+            state.writeFailed = !state.writer.append(entry, sizeof(entry))
+                             || !state.writer.append(state.sources[i].data(), state.sources[i].size());
+        }
+    }
+    // the mapping is gone after a failed write, and the file keeps the zeroed header which no reader accepts
+    if (!state.writeFailed) { memcpy(state.writer.at(0), &header, sizeof(header)); }
+    state.writer.close();
+    return !state.writeFailed;
+}
+
+bool convertTraceToChromeJson(std::string const& tracePath, std::string const& jsonPath) {
+    utils::file_utils::MappedFile file(tracePath);
+    if (!file.isOpen()) { return false; }
+    auto data = file.getData();
+    if (data.size() < sizeof(TraceFileHeader)) { return false; }
+    TraceFileHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+    if (memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || header.namesOffset > data.size()
+        || header.recordCount > (header.namesOffset - sizeof(header)) / sizeof(TraceRecord)) {
+        return false;
+    }
+
+    std::unordered_map<uint32_t, std::string> names;
+    size_t                                    offset = header.namesOffset;
+    uint32_t                                  count  = 0;
+    if (offset + sizeof(count) <= data.size()) {
+        memcpy(&count, data.data() + offset, sizeof(count));
+        offset += sizeof(count);
+    }
+    for (uint32_t i = 0; i < count && offset + 2 * sizeof(uint32_t) <= data.size(); ++i) {
+        uint32_t entry[2];
+        memcpy(entry, data.data() + offset, sizeof(entry));
+        offset += sizeof(entry);
+        if (offset + entry[1] > data.size()) { break; }
+        names[entry[0]].assign((char const*)data.data() + offset, entry[1]);
+        offset += entry[1];
+    }
+
+    double ticksPerMicrosecond = header.ticksPerSecond ? (double)header.ticksPerSecond / 1e6 : 1.0;
+    auto   out                 = fmt::memory_buffer();
+    fmt::format_to(
+        std::back_inserter(out),
+        R"({{"displayTimeUnit":"ns","otherData":{{"droppedRecords":{}}},"traceEvents":[)",
+        header.droppedCount
+    );
+    for (uint64_t i = 0; i < header.recordCount; ++i) {
+        TraceRecord record;
+        memcpy(&record, data.data() + sizeof(header) + i * sizeof(TraceRecord), sizeof(record));
+        auto source = record.source & ~TRACE_EXIT_FLAG;
+        auto it     = names.find(source);
+        fmt::format_to(
+            std::back_inserter(out),
+            R"({}{{"name":"{}","ph":"{}","ts":{:.3f},"pid":0,"tid":{}}})",
+            i ? "," : "",
+            it != names.end() ? it->second : fmt::format("hook#{}", source),
+            record.source & TRACE_EXIT_FLAG ? 'E' : 'B',
+            (double)(int64_t)(record.ticks - header.startTicks) / ticksPerMicrosecond,
+            record.threadId
+        );
+    }
+    fmt::format_to(std::back_inserter(out), "]}}");
+    return utils::file_utils::writeFile(jsonPath, {(uint8_t const*)out.data(), out.size()});
+}
+
+} // namespace glacie::memory
\ No newline at end of file
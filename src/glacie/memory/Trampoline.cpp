@@ -0,0 +1,579 @@
+#include "glacie/memory/Trampoline.h"
+#include "glacie/memory/PatchBatch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#ifdef _WIN32
+#include "windows.h"
+#include <intrin.h>
+#else
+#include <cstdio>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace glacie::memory {
+
+namespace {
+
+constexpr size_t    JUMP_SIZE            = 5;  // jmp rel32
+constexpr size_t    SHORT_JUMP_SIZE      = 2;  // jmp rel8
+constexpr size_t    ABSOLUTE_JUMP_SIZE   = 14; // jmp [rip+0]; dq address
+constexpr size_t    ABSOLUTE_JUMP_TARGET = 6;  // offset of the address, read as data by the jump
+constexpr size_t    CODE_BLOCK_SIZE      = 64 * 1024;
+constexpr size_t    TRAMPOLINE_SLOT_SIZE = 128;
+constexpr size_t    RELAY_OFFSET         = 0;
+constexpr size_t    TRAMPOLINE_OFFSET    = 16;
+constexpr uintptr_t NEAR_RANGE           = 0x7FF00000; // a rel32 displacement with some margin
+
+struct Instruction {
+    size_t  length{};
+    size_t  opcodeOffset{};
+    size_t  dispOffset{}; // offset of a rip-relative disp32, 0 if there is none
+    size_t  relOffset{};  // offset of a relative branch displacement, 0 if there is none
+    size_t  relSize{};
+    uint8_t opcode{};
+    bool    twoByte{};
+    bool    terminal{}; // execution does not continue after the instruction
+};
+
+// opcodes after 0x0F which have no ModRM byte
+bool isTwoByteWithoutModrm(uint8_t op) {
+    return (op >= 0x05 && op <= 0x09) || op == 0x0B || op == 0x0E || (op >= 0x30 && op <= 0x37) || op == 0x77
+        || (op >= 0xA0 && op <= 0xA2) || (op >= 0xA8 && op <= 0xAA) || (op >= 0xC8 && op <= 0xCF);
+}
+
+// opcodes after 0x0F which have a ModRM byte and an imm8
+bool isTwoByteWithImm8(uint8_t op) {
+    return (op >= 0x70 && op <= 0x73) || op == 0xA4 || op == 0xAC || op == 0xBA || op == 0xC2
+        || (op >= 0xC4 && op <= 0xC6);
+}
+
+bool decodeInstruction(uint8_t const* code, Instruction& result) {
+    result        = {};
+    size_t i      = 0;
+    bool   opSize = false, addrSize = false, rexW = false;
+    for (;; ++i) {
+        auto b = code[i];
+        if (b == 0x66) {
+            opSize = true;
+        } else if (b == 0x67) {
+            addrSize = true;
+        } else if (b != 0xF0 && b != 0xF2 && b != 0xF3 && b != 0x2E && b != 0x36 && b != 0x3E && b != 0x26
+                   && b != 0x64 && b != 0x65) {
+            break;
+        }
+        if (i >= 14) { return false; }
+    }
+    if ((code[i] & 0xF0) == 0x40) { rexW = code[i++] & 0x08; }
+    result.opcodeOffset = i;
+
+    auto   op    = code[i++];
+    auto   immz  = opSize && !rexW ? 2 : 4;
+    bool   modrm = false;
+    size_t imm   = 0;
+    if (op == 0x0F) {
+        result.twoByte = true;
+        op             = code[i++];
+        if (op == 0x38 || op == 0x3A) {
+            imm   = op == 0x3A ? 1 : 0;
+            modrm = true;
+            ++i;
+        } else if (op >= 0x80 && op <= 0x8F) {
+            result.relSize = 4;
+        } else if (!isTwoByteWithoutModrm(op)) {
+            modrm = true;
+            imm   = isTwoByteWithImm8(op) ? 1 : 0;
+        }
+    } else if (op == 0xC4 || op == 0xC5) {
+        // VEX, the map selects 0x0F, 0x0F38 or 0x0F3A
+        auto map = op == 0xC5 ? 1 : code[i] & 0x1F;
+        if (map < 1 || map > 3) { return false; }
+        i     += op == 0xC5 ? 1 : 2;
+        op     = code[i++];
+        imm    = map == 3 ? 1 : 0;
+        modrm  = map != 1 || op != 0x77; // vzeroupper and vzeroall have no operands
+    } else if (op < 0x40) {
+        switch (op & 7) {
+        case 4: imm = 1; break;
+        case 5: imm = immz; break;
+        case 6:
+        case 7: return false;
+        default: modrm = true; break;
+        }
+    } else if ((op >= 0x50 && op <= 0x5F) || (op >= 0x6C && op <= 0x6F) || (op >= 0x90 && op <= 0x99)
+               || (op >= 0x9B && op <= 0x9F) || (op >= 0xA4 && op <= 0xA7) || (op >= 0xAA && op <= 0xAF)
+               || (op >= 0xEC && op <= 0xEF) || op == 0xC9 || op == 0xCC || op == 0xF1 || op == 0xF4 || op == 0xF5
+               || (op >= 0xF8 && op <= 0xFD)) {
+    } else if (op == 0xC3 || op == 0xCB || op == 0xCF) {
+        result.terminal = true;
+    } else if (op == 0xC2 || op == 0xCA) {
+        imm             = 2;
+        result.terminal = true;
+    } else if (op == 0x63 || (op >= 0x84 && op <= 0x8F) || (op >= 0xD0 && op <= 0xD3) || (op >= 0xD8 && op <= 0xDF)
+               || op == 0xFE) {
+        modrm = true;
+    } else if (op == 0x69 || op == 0x81 || op == 0xC7) {
+        modrm = true;
+        imm   = immz;
+    } else if (op == 0x6B || op == 0x80 || op == 0x83 || op == 0xC0 || op == 0xC1 || op == 0xC6) {
+        modrm = true;
+        imm   = 1;
+    } else if (op == 0x68 || op == 0xA9) {
+        imm = immz;
+    } else if (op == 0x6A || op == 0xA8 || op == 0xCD || (op >= 0xB0 && op <= 0xB7) || (op >= 0xE4 && op <= 0xE7)) {
+        imm = 1;
+    } else if (op >= 0xA0 && op <= 0xA3) {
+        imm = addrSize ? 4 : 8;
+    } else if (op >= 0xB8 && op <= 0xBF) {
+        imm = rexW ? 8 : immz;
+    } else if (op == 0xC8) {
+        imm = 3;
+    } else if ((op >= 0x70 && op <= 0x7F) || (op >= 0xE0 && op <= 0xE3) || op == 0xEB) {
+        result.relSize  = 1;
+        result.terminal = op == 0xEB;
+    } else if (op == 0xE8 || op == 0xE9) {
+        result.relSize  = 4;
+        result.terminal = op == 0xE9;
+    } else if (op == 0xF6 || op == 0xF7) {
+        modrm = true;
+        // only test has an immediate
+        if ((code[i] >> 3 & 7) < 2) { imm = op == 0xF6 ? 1 : immz; }
+    } else if (op == 0xFF) {
+        modrm = true;
+        // jmp r/m and jmp far m
+        result.terminal = (code[i] >> 3 & 7) == 4 || (code[i] >> 3 & 7) == 5;
+    } else {
+        return false;
+    }
+
+    if (modrm) {
+        auto m   = code[i++];
+        auto mod = m >> 6, rm = m & 7;
+        if (mod == 0 && rm == 5) {
+            // only this form is rip-relative
+            if (addrSize) { return false; }
+            result.dispOffset  = i;
+            i                 += 4;
+        } else if (mod == 0 && rm == 4 && (code[i] & 7) == 5) {
+            // a SIB without base takes a disp32
+            i += 5;
+        } else if (mod != 3) {
+            i += (rm == 4 ? 1 : 0) + (mod == 1 ? 1 : mod == 2 ? 4 : 0);
+        }
+    }
+    if (result.relSize) {
+        result.relOffset  = i;
+        i                += result.relSize;
+    }
+    result.length = i + imm;
+    result.opcode = op;
+    return result.length <= 15;
+}
+
+bool isPadding(uint8_t const* code, Instruction const& inst) {
+    auto op = code[inst.opcodeOffset];
+    return op == 0xCC || op == 0x90 || (inst.twoByte && inst.opcode == 0x1F);
+}
+
+bool fitsRel32(int64_t value) { return value >= INT32_MIN && value <= INT32_MAX; }
+
+void emitAbsoluteJump(uint8_t* code, uintptr_t destination) {
+    code[0] = 0xFF;
+    code[1] = 0x25;
+    memset(code + 2, 0, 4);
+    memcpy(code + ABSOLUTE_JUMP_TARGET, &destination, sizeof(destination));
+}
+
+// copy the instructions covering the first minimum bytes of source into code, which runs at address
+// destination, and return the number of source bytes that were taken
+size_t relocateInstructions(uint8_t const* source, size_t minimum, uintptr_t destination, std::vector<uint8_t>& code) {
+    size_t taken    = 0;
+    bool   terminal = false;
+    while (taken < minimum) {
+        Instruction inst;
+        auto        src = source + taken;
+        if (!decodeInstruction(src, inst)) { return 0; }
+        // a function shorter than the jump can only be overwritten if it is followed by padding
+        if (terminal) {
+            if (!isPadding(src, inst)) { return 0; }
+            taken += inst.length;
+            continue;
+        }
+        auto at = destination + code.size();
+        if (inst.relSize) {
+            int64_t rel = 0;
+            if (inst.relSize == 1) {
+                rel = (int8_t)src[inst.relOffset];
+            } else {
+                int32_t rel32;
+                memcpy(&rel32, src + inst.relOffset, sizeof(rel32));
+                rel = rel32;
+            }
+            auto branch = (uintptr_t)src + inst.length + rel;
+            // loop and jrcxz have no rel32 form, and branches back into the overwritten bytes cannot be kept
+            if ((!inst.twoByte && inst.opcode >= 0xE0 && inst.opcode <= 0xE3)
+                || (branch > (uintptr_t)source && branch < (uintptr_t)source + minimum)) {
+                return 0;
+            }
+            if (inst.relSize == 1 && inst.opcode == 0xEB) {
+                code.push_back(0xE9);
+            } else if (inst.relSize == 1) {
+                code.push_back(0x0F);
+                code.push_back(0x80 | (inst.opcode & 0x0F));
+            } else {
+                code.insert(code.end(), src, src + inst.relOffset);
+            }
+            auto newRel = (int64_t)(branch - (destination + code.size() + 4));
+            if (!fitsRel32(newRel)) { return 0; }
+            auto rel32 = (int32_t)newRel;
+            code.insert(code.end(), (uint8_t const*)&rel32, (uint8_t const*)&rel32 + 4);
+        } else {
+            code.insert(code.end(), src, src + inst.length);
+            if (inst.dispOffset) {
+                int32_t disp;
+                memcpy(&disp, src + inst.dispOffset, sizeof(disp));
+                auto newDisp = (int64_t)disp + ((int64_t)(uintptr_t)src - (int64_t)at);
+                if (!fitsRel32(newDisp)) { return 0; }
+                disp = (int32_t)newDisp;
+                memcpy(code.data() + (at - destination) + inst.dispOffset, &disp, sizeof(disp));
+            }
+        }
+        taken    += inst.length;
+        terminal  = inst.terminal;
+    }
+    return taken;
+}
+
+struct CodeBlock {
+    uintptr_t           address{};
+    std::vector<size_t> freeSlots{};
+};
+
+enum class PatchKind : uint8_t {
+    Plain,    // jmp rel32 written while no other thread may run the target
+    Atomic,   // jmp rel32 inside one aligned block, replaced with a single store
+    HotPatch, // jmp rel32 in the padding before the target, reached by a jmp rel8 replaced with a single store
+};
+
+struct TrampolineData {
+    uintptr_t            target{};
+    uintptr_t            slot{};
+    PatchKind            kind{};
+    std::vector<uint8_t> original{}; // the bytes of the padding and the target which were overwritten
+    bool                 attached{}; // whether the entry of target jumps to the relay
+};
+
+// an aligned 16 byte block is written by one lock cmpxchg16b, which other threads fetch either before or
+// after the write, never in between
+bool isAtomicWritable(uintptr_t address, size_t len) { return (address & 15) + len <= 16; }
+
+bool compareExchange16(uint64_t* block, uint64_t* expected, uint64_t const* desired) {
+#ifdef _MSC_VER
+    return _InterlockedCompareExchange128(
+        (long long volatile*)block,
+        (long long)desired[1],
+        (long long)desired[0],
+        (long long*)expected
+    );
+#else
+    bool success;
+    asm volatile("lock cmpxchg16b %1"
+                 : "=@ccz"(success), "+m"(*(unsigned __int128*)block), "+a"(expected[0]), "+d"(expected[1])
+                 : "b"(desired[0]), "c"(desired[1])
+                 : "memory");
+    return success;
+#endif
+}
+
+// ThreadSanitizer has no writable shadow for the code of a loaded image, so code is written by instructions
+// it does not instrument, the page has to be writable
+void writeCode(uintptr_t address, uint8_t const* bytes, size_t len) {
+#ifdef _WIN32
+    memcpy((void*)address, bytes, len);
+#else
+    asm volatile("rep movsb" : "+D"(address), "+S"(bytes), "+c"(len) : : "memory");
+#endif
+}
+
+// the page has to be writable
+void writeAtomic(uintptr_t address, uint8_t const* bytes, size_t len) {
+    if ((address & 7) + len <= 8) {
+        auto                      word = (uint64_t*)(address & ~(uintptr_t)7);
+        std::atomic_ref<uint64_t> ref(*word);
+        auto                      value = ref.load(std::memory_order_relaxed);
+        memcpy((uint8_t*)&value + (address & 7), bytes, len);
+#ifdef _WIN32
+        ref.store(value, std::memory_order_release);
+#else
+        // an aligned store is atomic and has release order on x86-64, see writeCode
+        asm volatile("movq %1, %0" : "=m"(*word) : "r"(value) : "memory");
+#endif
+        return;
+    }
+    auto block = (uint64_t*)(address & ~(uintptr_t)15);
+    alignas(16) uint64_t expected[2], desired[2];
+    memcpy(expected, block, sizeof(expected));
+    do {
+        memcpy(desired, expected, sizeof(desired));
+        memcpy((uint8_t*)desired + (address & 15), bytes, len);
+    } while (!compareExchange16(block, expected, desired));
+}
+
+// padding left by the compiler in front of a function, on the same page so it is known to be mapped
+bool hasHotPatchPad(uintptr_t target) {
+    if ((target & 0xFFF) < JUMP_SIZE) { return false; }
+    return std::all_of((uint8_t const*)target - JUMP_SIZE, (uint8_t const*)target, [](uint8_t b) {
+        return b == 0xCC || b == 0x90;
+    });
+}
+
+void emitRelativeJump(uint8_t* code, uintptr_t at, uintptr_t destination) {
+    auto rel32 = (int32_t)(destination - (at + JUMP_SIZE));
+    code[0]    = 0xE9;
+    memcpy(code + 1, &rel32, sizeof(rel32));
+}
+
+} // namespace
+
+struct TrampolineState {
+    std::mutex                                    mutex;
+    std::vector<CodeBlock>                        blocks;
+    std::unordered_map<uintptr_t, TrampolineData> trampolines; // by trampoline, kept after the detach
+    std::unordered_map<uintptr_t, uintptr_t>      targets;     // target -> trampoline
+};
+
+TrampolineState& getTrampolineState() {
+    // never destroyed, threads may run the slots at any time
+    static auto& state = *new TrampolineState;
+    return state;
+}
+
+static bool isNear(uintptr_t a, uintptr_t b) { return (a > b ? a - b : b - a) < NEAR_RANGE - CODE_BLOCK_SIZE; }
+
+// reserve a block of executable memory within rel32 range of target
+static uintptr_t allocateNearBlock(uintptr_t target) {
+    auto low  = target > NEAR_RANGE ? target - NEAR_RANGE + CODE_BLOCK_SIZE : CODE_BLOCK_SIZE;
+    auto high = target + NEAR_RANGE - 2 * CODE_BLOCK_SIZE;
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    auto                     granularity = (uintptr_t)info.dwAllocationGranularity;
+    MEMORY_BASIC_INFORMATION region;
+    for (auto address = (low + granularity - 1) & ~(granularity - 1); address < high;) {
+        if (!VirtualQuery((void*)address, &region, sizeof(region))) { break; }
+        auto end = (uintptr_t)region.BaseAddress + region.RegionSize;
+        if (region.State == MEM_FREE && end - address >= CODE_BLOCK_SIZE) {
+            auto block = VirtualAlloc((void*)address, CODE_BLOCK_SIZE, MEM_RESERVE | MEM_COMMIT, PAGE_EXECUTE_READ);
+            if (block) { return (uintptr_t)block; }
+        }
+        address = (end + granularity - 1) & ~(granularity - 1);
+    }
+#else
+    // look for a gap between the mappings, closest to target first
+    std::vector<std::pair<uintptr_t, uintptr_t>> gaps;
+    FILE*                                        file = fopen("/proc/self/maps", "r");
+    if (!file) { return 0; }
+    uintptr_t begin, end, last = 0;
+    while (fscanf(file, "%lx-%lx%*[^\n]", &begin, &end) == 2) {
+        if (begin > last) { gaps.emplace_back(last, begin); }
+        last = end;
+    }
+    fclose(file);
+    auto pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+    std::vector<uintptr_t> candidates;
+    for (auto [gapBegin, gapEnd] : gaps) {
+        gapBegin = std::max((gapBegin + pageSize - 1) & ~(pageSize - 1), low);
+        gapEnd   = std::min(gapEnd, high);
+        if (gapBegin >= gapEnd || gapEnd - gapBegin < CODE_BLOCK_SIZE) { continue; }
+        candidates.push_back(gapEnd <= target ? gapEnd - CODE_BLOCK_SIZE : gapBegin);
+    }
+    std::sort(candidates.begin(), candidates.end(), [&](uintptr_t a, uintptr_t b) {
+        return (a > target ? a - target : target - a) < (b > target ? b - target : target - b);
+    });
+    for (auto address : candidates) {
+        auto block = mmap(
+            (void*)address,
+            CODE_BLOCK_SIZE,
+            PROT_READ | PROT_EXEC,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+            -1,
+            0
+        );
+        if (block == MAP_FAILED) { continue; }
+        if ((uintptr_t)block == address) { return address; }
+        // kernels before 4.17 treat the flag as a hint
+        munmap(block, CODE_BLOCK_SIZE);
+    }
+#endif
+    return 0;
+}
+
+static uintptr_t allocateSlot(TrampolineState& state, uintptr_t target) {
+    for (auto& block : state.blocks) {
+        if (block.freeSlots.empty() || !isNear(block.address, target)) { continue; }
+        auto slot = block.freeSlots.back();
+        block.freeSlots.pop_back();
+        return block.address + slot * TRAMPOLINE_SLOT_SIZE;
+    }
+    auto address = allocateNearBlock(target);
+    if (!address) { return 0; }
+    auto& block = state.blocks.emplace_back(CodeBlock{address, {}});
+    for (size_t i = CODE_BLOCK_SIZE / TRAMPOLINE_SLOT_SIZE; i > 1; --i) { block.freeSlots.push_back(i - 1); }
+    return address;
+}
+
+static void freeSlot(TrampolineState& state, uintptr_t slot) {
+    for (auto& block : state.blocks) {
+        if (slot < block.address || slot >= block.address + CODE_BLOCK_SIZE) { continue; }
+        block.freeSlots.push_back((slot - block.address) / TRAMPOLINE_SLOT_SIZE);
+        return;
+    }
+}
+
+size_t getInstructionLength(void const* code) {
+    Instruction inst;
+    return decodeInstruction((uint8_t const*)code, inst) ? inst.length : 0;
+}
+
+// the padding jump and the relay are never restored, so a thread which fetched the entry before it changed
+// still ends up in detour or in the trampoline, whichever the relay holds when it gets there
+static bool writeRelay(uintptr_t slot, uintptr_t destination) {
+    return PatchBatch{}.touch((void*)(slot + RELAY_OFFSET), ABSOLUTE_JUMP_SIZE).commit([&] {
+        writeAtomic(slot + RELAY_OFFSET + ABSOLUTE_JUMP_TARGET, (uint8_t const*)&destination, sizeof(destination));
+    });
+}
+
+static bool writeEntry(TrampolineData const& data, FuncPtr* originalFunc) {
+    uint8_t jump[JUMP_SIZE + SHORT_JUMP_SIZE];
+    auto    begin = data.kind == PatchKind::HotPatch ? data.target - JUMP_SIZE : data.target;
+    auto    entry = jump + (data.kind == PatchKind::HotPatch ? JUMP_SIZE : 0);
+    emitRelativeJump(jump, begin, data.slot + RELAY_OFFSET);
+    if (data.kind == PatchKind::HotPatch) {
+        entry[0] = 0xEB;
+        entry[1] = (uint8_t)-(int8_t)(JUMP_SIZE + SHORT_JUMP_SIZE);
+    }
+    auto entrySize = data.kind == PatchKind::HotPatch ? SHORT_JUMP_SIZE : JUMP_SIZE;
+    auto size      = (size_t)(entry - jump) + entrySize;
+    // the trampoline has to be usable before the first call reaches the detour
+    std::atomic_ref(*originalFunc).store((FuncPtr)(data.slot + TRAMPOLINE_OFFSET), std::memory_order_release);
+    auto committed = PatchBatch{}.touch((void*)begin, size).commit([&] {
+        // the padding is not executed yet or already holds this jump, so only the entry has to be replaced at once
+        writeCode(begin, jump, entry - jump);
+        if (data.kind == PatchKind::Plain) {
+            writeCode(data.target, entry, entrySize);
+        } else {
+            writeAtomic(data.target, entry, entrySize);
+        }
+    });
+    if (!committed) { std::atomic_ref(*originalFunc).store((FuncPtr)data.target, std::memory_order_release); }
+    return committed;
+}
+
+int attachTrampoline(FuncPtr target, FuncPtr detour, FuncPtr* originalFunc, bool live) {
+    auto            address = (uintptr_t)target;
+    auto&           state   = getTrampolineState();
+    std::lock_guard lock(state.mutex);
+
+    // a target which was attached before gets its slot back, its trampoline still matches the code
+    if (auto known = state.targets.find(address); known != state.targets.end()) {
+        auto& data    = state.trampolines.at(known->second);
+        auto  padSize = data.kind == PatchKind::HotPatch ? JUMP_SIZE : 0;
+        if (data.attached) { return -1; }
+        if (std::equal(data.original.begin() + padSize, data.original.end(), (uint8_t const*)address)) {
+            if (live && data.kind == PatchKind::Plain) { return -1; }
+            if (!writeRelay(data.slot, (uintptr_t)detour) || !writeEntry(data, originalFunc)) { return -1; }
+            data.attached = true;
+            return 0;
+        }
+        // the code was replaced behind our back, the old slot stays with whoever may still run it
+        state.trampolines.erase(known->second);
+        state.targets.erase(known);
+    }
+
+    Instruction first;
+    if (!decodeInstruction((uint8_t const*)target, first)) { return -1; }
+    // no thread can be stopped inside the bytes replaced by a single store if they belong to one instruction
+    PatchKind kind;
+    if (first.length >= JUMP_SIZE && isAtomicWritable(address, JUMP_SIZE)) {
+        kind = PatchKind::Atomic;
+    } else if (first.length >= SHORT_JUMP_SIZE && isAtomicWritable(address, SHORT_JUMP_SIZE)
+               && hasHotPatchPad(address)) {
+        kind = PatchKind::HotPatch;
+    } else if (!live) {
+        kind = PatchKind::Plain;
+    } else {
+        return -1;
+    }
+
+    auto slot = allocateSlot(state, address);
+    if (!slot) { return -1; }
+
+    // the relay jumps to the detour, which may be anywhere, and the trampoline follows it
+    std::vector<uint8_t> code(TRAMPOLINE_OFFSET, 0xCC);
+    emitAbsoluteJump(code.data() + RELAY_OFFSET, (uintptr_t)detour);
+    auto minimum = kind == PatchKind::HotPatch ? first.length : JUMP_SIZE;
+    auto taken   = relocateInstructions((uint8_t const*)target, minimum, slot + TRAMPOLINE_OFFSET, code);
+    if (!taken || code.size() + ABSOLUTE_JUMP_SIZE > TRAMPOLINE_SLOT_SIZE) {
+        freeSlot(state, slot);
+        return -1;
+    }
+    code.resize(code.size() + ABSOLUTE_JUMP_SIZE);
+    emitAbsoluteJump(code.data() + code.size() - ABSOLUTE_JUMP_SIZE, address + taken);
+    if (!PatchBatch{}.add((void*)slot, code).commit()) {
+        freeSlot(state, slot);
+        return -1;
+    }
+
+    auto           begin = kind == PatchKind::HotPatch ? address - JUMP_SIZE : address;
+    auto           size  = kind == PatchKind::HotPatch ? JUMP_SIZE + SHORT_JUMP_SIZE : JUMP_SIZE;
+    TrampolineData data{address, slot, kind, {(uint8_t const*)begin, (uint8_t const*)begin + size}, true};
+    if (!writeEntry(data, originalFunc)) {
+        freeSlot(state, slot);
+        return -1;
+    }
+    state.trampolines.emplace(slot + TRAMPOLINE_OFFSET, std::move(data));
+    state.targets.emplace(address, slot + TRAMPOLINE_OFFSET);
+    return 0;
+}
+
+int detachTrampoline(FuncPtr* originalFunc) {
+    auto&           state = getTrampolineState();
+    std::lock_guard lock(state.mutex);
+    auto            it = state.trampolines.find((uintptr_t)*originalFunc);
+    if (it == state.trampolines.end() || !it->second.attached) { return -1; }
+    auto& data      = it->second;
+    auto  padSize   = data.kind == PatchKind::HotPatch ? JUMP_SIZE : 0;
+    auto  entry     = data.original.data() + padSize;
+    auto  entrySize = data.original.size() - padSize;
+    auto  committed = PatchBatch{}.touch((void*)data.target, entrySize).commit([&] {
+        if (data.kind == PatchKind::Plain) {
+            writeCode(data.target, entry, entrySize);
+        } else {
+            writeAtomic(data.target, entry, entrySize);
+        }
+    });
+    if (!committed) { return -1; }
+    // from here on a thread which fetched the old entry runs the original instructions instead of the detour
+    writeRelay(data.slot, data.slot + TRAMPOLINE_OFFSET);
+    data.attached = false;
+    std::atomic_ref(*originalFunc).store((FuncPtr)data.target, std::memory_order_release);
+    return 0;
+}
+
+int discardTrampoline(FuncPtr* originalFunc) {
+    auto&           state = getTrampolineState();
+    std::lock_guard lock(state.mutex);
+    auto            it = state.trampolines.find((uintptr_t)*originalFunc);
+    if (it == state.trampolines.end()) { return -1; }
+    state.targets.erase(it->second.target);
+    state.trampolines.erase(it);
+    return 0;
+}
+
+} // namespace glacie::memory
\ No newline at end of file
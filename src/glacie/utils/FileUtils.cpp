@@ -0,0 +1,106 @@
+#include "glacie/utils/FileUtils.h"
+
+#include <cstdio>
+#include <utility>
+
+#ifdef _WIN32
+#include "glacie/utils/StringUtils.h"
+
+#include "windows.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace glacie::utils::file_utils {
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+: data(std::exchange(other.data, nullptr)),
+  size(std::exchange(other.size, 0))
+#ifdef _WIN32
+  ,
+  mapping(std::exchange(other.mapping, nullptr))
+#endif
+{
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data = std::exchange(other.data, nullptr);
+        size = std::exchange(other.size, 0);
+#ifdef _WIN32
+        mapping = std::exchange(other.mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+bool MappedFile::open(std::string const& path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileW(
+        string_utils::str2wstr(path).c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (file == INVALID_HANDLE_VALUE) { return false; }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) { return false; }
+    data = (uint8_t const*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        mapping = nullptr;
+        return false;
+    }
+    size = (size_t)fileSize.QuadPart;
+#else
+    int file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) { return false; }
+    struct stat info {};
+    if (fstat(file, &info) != 0 || info.st_size == 0) {
+        ::close(file);
+        return false;
+    }
+    auto view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file);
+    if (view == MAP_FAILED) { return false; }
+    data = (uint8_t const*)view;
+    size = (size_t)info.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (!data) { return; }
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    munmap((void*)data, size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+bool writeFile(std::string const& path, std::span<uint8_t const> data) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) { return false; }
+    bool success = fwrite(data.data(), 1, data.size(), file) == data.size();
+    return fclose(file) == 0 && success;
+}
+
+} // namespace glacie::utils::file_utils
\ No newline at end of file
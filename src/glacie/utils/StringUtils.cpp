@@ -2,9 +2,12 @@
 
 #include "magic_enum.hpp"
 
-#include "stringapiset.h"
 #include <sstream>
 
+#ifdef _WIN32
+#include "stringapiset.h"
+#endif
+
 namespace glacie::utils::string_utils {
 
 fmt::text_style getTextStyleFromCode(std::string_view code) {
@@ -105,6 +108,42 @@ std::string getAnsiCodeFromTextStyle(fmt::text_style style) {
     return fmt::to_string(buf);
 }
 
+#ifndef _WIN32
+// wchar_t holds UTF-32 and only UTF-8 is supported as the narrow encoding, codePage is ignored
+std::wstring str2wstr(std::string_view str, uint32_t) {
+    std::wstring wstr;
+    wstr.reserve(str.size());
+    fmt::detail::for_each_codepoint(str, [&](uint32_t cp, fmt::string_view) {
+        wstr.push_back((wchar_t)(cp == fmt::detail::invalid_code_point ? 0xFFFD : cp));
+        return true;
+    });
+    return wstr;
+}
+
+std::string wstr2str(std::wstring_view str, uint32_t) {
+    std::string ret;
+    ret.reserve(str.size());
+    for (wchar_t c : str) {
+        auto cp = (uint32_t)c;
+        if (cp < 0x80) {
+            ret.push_back((char)cp);
+        } else if (cp < 0x800) {
+            ret.push_back((char)(0xC0 | cp >> 6));
+            ret.push_back((char)(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            ret.push_back((char)(0xE0 | cp >> 12));
+            ret.push_back((char)(0x80 | (cp >> 6 & 0x3F)));
+            ret.push_back((char)(0x80 | (cp & 0x3F)));
+        } else {
+            ret.push_back((char)(0xF0 | cp >> 18));
+            ret.push_back((char)(0x80 | (cp >> 12 & 0x3F)));
+            ret.push_back((char)(0x80 | (cp >> 6 & 0x3F)));
+            ret.push_back((char)(0x80 | (cp & 0x3F)));
+        }
+    }
+    return ret;
+}
+#else
 std::wstring str2wstr(std::string_view str, uint32_t codePage) {
     int len = MultiByteToWideChar(codePage, 0, str.data(), (int)str.size(), nullptr, 0);
     if (len == 0) { return {}; }
@@ -120,6 +159,7 @@ std::string wstr2str(std::wstring_view str, uint32_t codePage) {
     WideCharToMultiByte(codePage, 0, str.data(), (int)str.size(), ret.data(), (int)ret.size(), nullptr, nullptr);
     return ret;
 }
+#endif
 
 std::string str2str(std::string_view str, uint32_t fromCodePage, uint32_t toCodePage) {
     return wstr2str(str2wstr(str, fromCodePage), toCodePage);
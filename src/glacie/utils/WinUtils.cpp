@@ -1,25 +1,48 @@
 #include "glacie/utils/WinUtils.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <string>
 
 #include "glacie/utils/StringUtils.h"
 
+#ifdef _WIN32
 #include "windows.h"
 
 #include "psapi.h"
+#else
+#include <link.h>
+#endif
 
 using namespace glacie::utils::string_utils;
 namespace glacie::utils::win_utils {
 
 std::string getSystemLocaleName() {
+#ifndef _WIN32
+    // such as "en_US.UTF-8" from the environment
+    std::string locale = "en_US";
+    for (auto name : {"LC_ALL", "LC_MESSAGES", "LANG"}) {
+        auto value = getenv(name);
+        if (!value || !*value) { continue; }
+        locale = value;
+        break;
+    }
+    locale = locale.substr(0, locale.find_first_of(".@"));
+    if (locale == "C" || locale == "POSIX") { return "en_US"; }
+    return locale;
+#else
     wchar_t buf[LOCALE_NAME_MAX_LENGTH]{};
     GetSystemDefaultLocaleName(buf, LOCALE_NAME_MAX_LENGTH);
     auto str = wstr2str(buf);
     replaceAll(str, "-", "_");
     return str;
+#endif
 }
 
 bool isWine() {
+#ifndef _WIN32
+    return false;
+#else
     static bool result = []() {
         HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
         if (!ntdll) return false;
@@ -28,9 +51,39 @@ bool isWine() {
         else return false;
     }();
     return result;
+#endif
 }
 
+#ifndef _WIN32
+struct ImageSearch {
+    std::string const& name;
+    std::span<uint8_t> range;
+};
+#endif
+
 std::span<uint8_t> getImageRange(std::string const& name) {
+#ifndef _WIN32
+    ImageSearch search{name, {}};
+    dl_iterate_phdr(
+        [](dl_phdr_info* info, size_t, void* data) {
+            auto&            search = *(ImageSearch*)data;
+            std::string_view path   = info->dlpi_name ? info->dlpi_name : "";
+            // the main program comes first and has an empty name
+            if (!search.name.empty() && path.substr(path.find_last_of('/') + 1) != search.name) { return 0; }
+            uintptr_t begin = UINTPTR_MAX, end = 0;
+            for (int i = 0; i < info->dlpi_phnum; ++i) {
+                auto& header = info->dlpi_phdr[i];
+                if (header.p_type != PT_LOAD) { continue; }
+                begin = std::min<uintptr_t>(begin, info->dlpi_addr + header.p_vaddr);
+                end   = std::max<uintptr_t>(end, info->dlpi_addr + header.p_vaddr + header.p_memsz);
+            }
+            if (begin < end) { search.range = {(uint8_t*)begin, end - begin}; }
+            return 1;
+        },
+        &search
+    );
+    return search.range;
+#else
     static auto process = GetCurrentProcess();
     HMODULE     rangeStart;
     if (name.empty()) {
@@ -45,6 +98,7 @@ std::span<uint8_t> getImageRange(std::string const& name) {
         }
     }
     return {};
+#endif
 }
 
 } // namespace glacie::utils::win_utils
\ No newline at end of file
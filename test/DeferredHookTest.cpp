@@ -0,0 +1,48 @@
+#include "glacie/memory/DeferredHook.h"
+#include "glacie/memory/Epoch.h"
+
+#include <atomic>
+#include <dlfcn.h>
+#include <filesystem>
+
+#include "Test.h"
+
+using namespace glacie::memory;
+
+namespace {
+
+// the first instructions of glacieDeferredHookModuleTarget in test/module/DeferredHookModule.cpp
+constexpr char MODULE_NAME[]      = "libDeferredHookModule.so";
+constexpr char TARGET_SIGNATURE[] = "B8 0D D0 17 5A 2D 0C D0 17 5A";
+
+FuncPtr originalFunc{};
+
+int detour(int value) {
+    auto origin = (int (*)(int))std::atomic_ref(originalFunc).load(std::memory_order_acquire);
+    return origin(value) + 1000;
+}
+
+} // namespace
+
+int main() {
+    auto id = registerDeferredHook(MODULE_NAME, TARGET_SIGNATURE, (FuncPtr)&detour, &originalFunc);
+    GLACIE_CHECK(id > 0);
+    GLACIE_CHECK(!isDeferredHookInstalled(id));
+
+    // the hook is live as soon as dlopen returns, without waiting for the worker
+    std::error_code ec;
+    auto            path   = std::filesystem::read_symlink("/proc/self/exe", ec).parent_path() / MODULE_NAME;
+    auto            handle = dlopen(path.c_str(), RTLD_NOW);
+    GLACIE_CHECK(handle != nullptr);
+    if (!handle) { return glacie::test::getTestResult(); }
+    GLACIE_CHECK(isDeferredHookInstalled(id));
+    auto target = (int (*)(int))dlsym(handle, "glacieDeferredHookModuleTarget");
+    GLACIE_CHECK(target && target(5) == 1006);
+
+    // the module stays loaded, only the hook goes
+    GLACIE_CHECK(removeDeferredHook(id));
+    GLACIE_CHECK(!isDeferredHookInstalled(id));
+    synchronizeEpoch();
+    GLACIE_CHECK(target && target(5) == 6);
+    return glacie::test::getTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "glacie/memory/Memory.h"
+#include "glacie/memory/PatchBatch.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "Test.h"
+
+using namespace glacie::memory;
+
+// three overlapping matches of the patch signature in the code of the test executable, which is the server here
+extern "C" uint8_t glacieFindAllPatchSite[];
+asm(R"(
+.text
+.p2align 4
+.globl glacieFindAllPatchSite
+glacieFindAllPatchSite:
+    .byte 0x5A, 0x17, 0xFA, 0x11, 0x5A, 0x17, 0xFA, 0x11, 0x5A, 0x17, 0xFA, 0x11, 0xCC, 0xCC, 0xCC, 0xCC
+)");
+
+namespace {
+
+std::vector<std::byte> makeBytes(std::initializer_list<uint8_t> bytes) {
+    std::vector<std::byte> result;
+    for (auto byte : bytes) result.push_back((std::byte)byte);
+    return result;
+}
+
+// the offsets of the matches which findAll reports
+std::vector<size_t> findOffsets(std::vector<std::byte> const& range, char const* signature, size_t limit = 0) {
+    std::vector<size_t> result;
+    auto                count = findAll(
+        range,
+        signature,
+        [&](FuncPtr address) {
+            result.push_back((size_t)((std::byte const*)address - range.data()));
+            return true;
+        },
+        limit
+    );
+    GLACIE_CHECK(count == result.size());
+    return result;
+}
+
+void testOverlappingMatches() {
+    auto range = makeBytes({0xAA, 0xAA, 0xAA, 0xAA, 0x00, 0xAA});
+    // the scan resumes one byte after each match
+    GLACIE_CHECK(findOffsets(range, "AA AA") == std::vector<size_t>{0, 1, 2});
+    GLACIE_CHECK(findOffsets(range, "AA AA AA AA AA").empty());
+    GLACIE_CHECK(findOffsets(range, "").empty());
+}
+
+void testLimitAndCallback() {
+    auto range = makeBytes({0xAA, 0xAA, 0xAA, 0xAA});
+    GLACIE_CHECK(findOffsets(range, "AA", 2) == std::vector<size_t>{0, 1});
+    GLACIE_CHECK(findOffsets(range, "AA", 9).size() == 4);
+
+    // the match for which the callback returns false is counted, the scan stops after it
+    int  calls = 0;
+    auto count = findAll(range, "AA", [&](FuncPtr) { return ++calls < 2; });
+    GLACIE_CHECK(count == 2 && calls == 2);
+}
+
+void testWildcards() {
+    auto range = makeBytes({0x11, 0x22, 0x33, 0x11, 0x44, 0x33, 0x11, 0x44, 0x55});
+    GLACIE_CHECK(findOffsets(range, "11 ? 33") == std::vector<size_t>{0, 3});
+    GLACIE_CHECK(findOffsets(range, "11 ?? 33") == std::vector<size_t>{0, 3});
+    GLACIE_CHECK(findOffsets(range, "? 44") == std::vector<size_t>{3, 6});
+}
+
+void testMatchAtEnd() {
+    auto range = makeBytes({0x00, 0x01, 0x02, 0x03});
+    GLACIE_CHECK(findOffsets(range, "02 03") == std::vector<size_t>{2});
+    GLACIE_CHECK(findOffsets(range, "03") == std::vector<size_t>{3});
+    // a match which would run past the end of the range is not reported
+    GLACIE_CHECK(findOffsets(range, "03 04").empty());
+    auto prefix = std::vector<std::byte>{range.begin(), range.end() - 1};
+    GLACIE_CHECK(findOffsets(prefix, "02 03").empty());
+}
+
+void testPatchOverlappingMatches() {
+    // every match is found in the original bytes before anything is written, then the writes are applied in
+    // ascending order, so where a write longer than the match overlaps the next one the later match wins
+    PatchBatch batch;
+    auto       count = patchAll(batch, "5A 17 FA 11 5A 17", {0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08});
+    GLACIE_CHECK(count == 2 && batch.size() == 2);
+    GLACIE_CHECK(batch.commit());
+    std::array<uint8_t, 16> const expected{1, 2, 3, 4, 1, 2, 3, 4, 5, 6, 7, 8, 0xCC, 0xCC, 0xCC, 0xCC};
+    GLACIE_CHECK(memcmp(glacieFindAllPatchSite, expected.data(), expected.size()) == 0);
+    GLACIE_CHECK(findAll("5A 17 FA 11").empty());
+}
+
+} // namespace
+
+int main() {
+    testOverlappingMatches();
+    testLimitAndCallback();
+    testWildcards();
+    testMatchAtEnd();
+    testPatchOverlappingMatches();
+    return glacie::test::getTestResult();
+}
\ No newline at end of file
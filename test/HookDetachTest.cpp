@@ -0,0 +1,112 @@
+#include "glacie/memory/Epoch.h"
+#include "glacie/memory/Hook.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "Test.h"
+
+using namespace glacie::memory;
+
+// returns value + 1, the 5 byte first instruction lets the prologue be replaced by a single store
+extern "C" int glacieHookDetachTestTarget(int value);
+asm(R"(
+.text
+.p2align 4
+.globl glacieHookDetachTestTarget
+glacieHookDetachTestTarget:
+    mov $1, %eax
+    add %edi, %eax
+    ret
+)");
+
+GLACIE_STATIC_HOOK(HookDetachTestHook, &glacieHookDetachTestTarget, int, int value) { return origin(value) * 10; }
+
+namespace {
+
+int (*volatile target)(int) = &glacieHookDetachTestTarget;
+
+// the fastest of several rounds, in nanoseconds per call
+double measureCallNs() {
+    constexpr int ITERATIONS = 2'000'000;
+    double        best       = 1e300;
+    int           sum        = 0;
+    for (int round = 0; round < 7; ++round) {
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; ++i) sum += target(i);
+        auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+        best         = std::min(best, elapsed / ITERATIONS);
+    }
+    asm volatile("" : : "r"(sum));
+    return best;
+}
+
+bool isPrologueRestored(uint8_t const* original) {
+    return memcmp(original, (void*)&glacieHookDetachTestTarget, 16) == 0;
+}
+
+// a guard on another thread holds the restore back, which has to happen on its own once the guard is gone
+void testDetachWhileGuarded(uint8_t const* original) {
+    std::atomic_int step{};
+    std::thread     reader([&] {
+        EpochGuard guard;
+        step = 1;
+        while (step.load() != 2) std::this_thread::yield();
+    });
+    while (step.load() != 1) std::this_thread::yield();
+
+    GLACIE_CHECK(HookDetachTestHook::hook() == 0);
+    GLACIE_CHECK(HookDetachTestHook::unhook());
+    GLACIE_CHECK(target(3) == 4);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    GLACIE_CHECK(!isPrologueRestored(original));
+
+    // nothing on this thread reclaims from here on
+    step = 2;
+    reader.join();
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!isPrologueRestored(original) && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    GLACIE_CHECK(isPrologueRestored(original));
+    GLACIE_CHECK(target(3) == 4);
+}
+
+} // namespace
+
+int main() {
+    uint8_t original[16];
+    memcpy(original, (void*)&glacieHookDetachTestTarget, sizeof(original));
+    auto baseline = measureCallNs();
+
+    GLACIE_CHECK(HookDetachTestHook::hook() == 0);
+    GLACIE_CHECK(target(1) == 20);
+    GLACIE_CHECK(memcmp(original, (void*)&glacieHookDetachTestTarget, sizeof(original)) != 0);
+    auto hooked = measureCallNs();
+
+    GLACIE_CHECK(HookDetachTestHook::unhook());
+    // the detach waits for the grace period, then the prologue is the original again
+    synchronizeEpoch();
+    GLACIE_CHECK(target(1) == 2);
+    GLACIE_CHECK(memcmp(original, (void*)&glacieHookDetachTestTarget, sizeof(original)) == 0);
+    auto detached = measureCallNs();
+    std::printf("baseline %.2f ns, hooked %.2f ns, detached %.2f ns\n", baseline, hooked, detached);
+    GLACIE_CHECK(detached < baseline * 1.5 + 0.5);
+    GLACIE_CHECK(!HookDetachTestHook::unhook());
+
+    // the thunk of the first hook is reused
+    GLACIE_CHECK(HookDetachTestHook::hook() == 0);
+    GLACIE_CHECK(target(2) == 30);
+    GLACIE_CHECK(HookDetachTestHook::unhook());
+    synchronizeEpoch();
+    GLACIE_CHECK(target(2) == 3);
+    GLACIE_CHECK(memcmp(original, (void*)&glacieHookDetachTestTarget, sizeof(original)) == 0);
+
+    testDetachWhileGuarded(original);
+    return glacie::test::getTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "glacie/memory/Epoch.h"
+#include "glacie/memory/Hook.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "../bench/Bench.h"
+#include "Test.h"
+
+// Hooks, unhooks and calls through one shared target and one target per thread from every thread, then prints
+// the latency percentiles. Arguments: [threads] [milliseconds]. Configure with
+// xmake f -p linux --policies=build.sanitizer.thread to run it under ThreadSanitizer, which sees the registry
+// and the call lists but not the patched machine code.
+
+using namespace glacie::memory;
+using namespace glacie::bench;
+
+// TARGET_COUNT functions returning value + 1, 16 bytes apart, the first one is shared by all threads
+extern "C" void glacieHookStressTargets();
+asm(R"(
+.text
+.p2align 4
+.globl glacieHookStressTargets
+glacieHookStressTargets:
+.rept 17
+    mov $1, %eax
+    add %edi, %eax
+    ret
+    .p2align 4
+.endr
+)");
+
+namespace {
+
+using TargetFunc = int (*)(int);
+
+constexpr size_t MAX_THREADS   = 16;
+constexpr size_t TARGET_COUNT  = MAX_THREADS + 1;
+constexpr size_t TARGET_STRIDE = 16;
+constexpr int    DETOUR_ADDEND = 1000;
+constexpr int    CALL_BATCH    = 64;
+
+uintptr_t getTargetAddress(size_t index) { return (uintptr_t)&glacieHookStressTargets + index * TARGET_STRIDE; }
+
+TargetFunc getTarget(size_t index) { return (TargetFunc)getTargetAddress(index); }
+
+} // namespace
+
+// each thread owns one hook definition on the shared target and one on its separate target, so that the sanitizer
+// checks the dispatch and the origin() which the macros generate
+#define GLACIE_STRESS_HOOKS(N)                                                                                         \
+    GLACIE_STATIC_HOOK(StressSharedHook##N, getTargetAddress(0), int, int value) {                                    \
+        return origin(value) + DETOUR_ADDEND;                                                                          \
+    }                                                                                                                  \
+    GLACIE_STATIC_HOOK(StressSeparateHook##N, getTargetAddress(N + 1), int, int value) {                              \
+        return origin(value) + DETOUR_ADDEND;                                                                          \
+    }
+
+GLACIE_STRESS_HOOKS(0)
+GLACIE_STRESS_HOOKS(1)
+GLACIE_STRESS_HOOKS(2)
+GLACIE_STRESS_HOOKS(3)
+GLACIE_STRESS_HOOKS(4)
+GLACIE_STRESS_HOOKS(5)
+GLACIE_STRESS_HOOKS(6)
+GLACIE_STRESS_HOOKS(7)
+GLACIE_STRESS_HOOKS(8)
+GLACIE_STRESS_HOOKS(9)
+GLACIE_STRESS_HOOKS(10)
+GLACIE_STRESS_HOOKS(11)
+GLACIE_STRESS_HOOKS(12)
+GLACIE_STRESS_HOOKS(13)
+GLACIE_STRESS_HOOKS(14)
+GLACIE_STRESS_HOOKS(15)
+
+namespace {
+
+struct StressHooks {
+    int (*hookShared)();
+    bool (*unhookShared)();
+    int (*hookSeparate)();
+    bool (*unhookSeparate)();
+};
+
+#define GLACIE_STRESS_HOOK_ENTRY(N)                                                                                    \
+    StressHooks {                                                                                                      \
+        &StressSharedHook##N::hook, &StressSharedHook##N::unhook, &StressSeparateHook##N::hook,                        \
+            &StressSeparateHook##N::unhook                                                                             \
+    }
+
+std::array<StressHooks, MAX_THREADS> const stressHooks{
+    GLACIE_STRESS_HOOK_ENTRY(0),
+    GLACIE_STRESS_HOOK_ENTRY(1),
+    GLACIE_STRESS_HOOK_ENTRY(2),
+    GLACIE_STRESS_HOOK_ENTRY(3),
+    GLACIE_STRESS_HOOK_ENTRY(4),
+    GLACIE_STRESS_HOOK_ENTRY(5),
+    GLACIE_STRESS_HOOK_ENTRY(6),
+    GLACIE_STRESS_HOOK_ENTRY(7),
+    GLACIE_STRESS_HOOK_ENTRY(8),
+    GLACIE_STRESS_HOOK_ENTRY(9),
+    GLACIE_STRESS_HOOK_ENTRY(10),
+    GLACIE_STRESS_HOOK_ENTRY(11),
+    GLACIE_STRESS_HOOK_ENTRY(12),
+    GLACIE_STRESS_HOOK_ENTRY(13),
+    GLACIE_STRESS_HOOK_ENTRY(14),
+    GLACIE_STRESS_HOOK_ENTRY(15),
+};
+
+// other threads add and remove their detours at any time, and a stale walk of the chain may pass or repeat
+// some of them, so only the shape of the result is certain
+bool isSharedResult(int value, int result) {
+    return result > value && (result - value - 1) % DETOUR_ADDEND == 0;
+}
+
+struct ThreadResult {
+    std::vector<uint64_t> callNs;
+    std::vector<uint64_t> hookNs;
+    std::vector<uint64_t> unhookNs;
+    uint64_t              wrongResults{};
+    uint64_t              failedHooks{};
+    uint64_t              failedUnhooks{};
+};
+
+uint64_t getElapsedNs(std::chrono::steady_clock::time_point begin) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin)
+        .count();
+}
+
+void callBatch(size_t index, size_t threadCount, bool hooked, ThreadResult& result) {
+    auto shared   = getTarget(0);
+    auto separate = getTarget(index + 1);
+    auto neighbor = getTarget((index + 1) % threadCount + 1);
+    for (int value = 0; value < CALL_BATCH; ++value) {
+        auto begin = std::chrono::steady_clock::now();
+        auto first = shared(value);
+        result.callNs.push_back(getElapsedNs(begin));
+        auto second = separate(value);
+        auto third  = neighbor(value);
+        // only this thread hooks its separate target
+        if (!isSharedResult(value, first)) ++result.wrongResults;
+        if (second != value + 1 + (hooked ? DETOUR_ADDEND : 0)) ++result.wrongResults;
+        if (third != value + 1 && third != value + 1 + DETOUR_ADDEND) ++result.wrongResults;
+    }
+}
+
+void runThread(size_t index, size_t threadCount, std::chrono::steady_clock::time_point deadline, ThreadResult& result) {
+    auto& hooks = stressHooks[index];
+    while (std::chrono::steady_clock::now() < deadline) {
+        auto begin = std::chrono::steady_clock::now();
+        if (hooks.hookShared() != 0) ++result.failedHooks;
+        result.hookNs.push_back(getElapsedNs(begin));
+        if (hooks.hookSeparate() != 0) ++result.failedHooks;
+        callBatch(index, threadCount, true, result);
+
+        begin = std::chrono::steady_clock::now();
+        if (!hooks.unhookShared()) ++result.failedUnhooks;
+        result.unhookNs.push_back(getElapsedNs(begin));
+        if (!hooks.unhookSeparate()) ++result.failedUnhooks;
+        callBatch(index, threadCount, false, result);
+    }
+}
+
+void printPercentiles(char const* name, std::vector<uint64_t>& samples) {
+    auto p50  = getPercentile(samples, 0.5);
+    auto p99  = getPercentile(samples, 0.99);
+    auto p999 = getPercentile(samples, 0.999);
+    auto max  = getPercentile(samples, 1.0);
+    std::printf(
+        "%-8s %10zu samples  p50 %8llu  p99 %8llu  p99.9 %8llu  max %8llu ns\n",
+        name,
+        samples.size(),
+        (unsigned long long)p50,
+        (unsigned long long)p99,
+        (unsigned long long)p999,
+        (unsigned long long)max
+    );
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t threadCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4;
+    auto   duration    = std::chrono::milliseconds(argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 500);
+    threadCount        = std::min(std::max<size_t>(threadCount, 1), MAX_THREADS);
+
+    uint8_t original[TARGET_STRIDE];
+    memcpy(original, (void*)getTarget(0), sizeof(original));
+
+    // the other threads keep calling the targets while their prologues are written
+    setLivePatching(true);
+    std::vector<ThreadResult> results(threadCount);
+    std::vector<std::thread>  threads;
+    auto                      deadline = std::chrono::steady_clock::now() + duration;
+    for (size_t i = 0; i < threadCount; ++i) {
+        threads.emplace_back(runThread, i, threadCount, deadline, std::ref(results[i]));
+    }
+    for (auto& thread : threads) thread.join();
+    setLivePatching(false);
+
+    ThreadResult total;
+    for (auto& result : results) {
+        total.callNs.insert(total.callNs.end(), result.callNs.begin(), result.callNs.end());
+        total.hookNs.insert(total.hookNs.end(), result.hookNs.begin(), result.hookNs.end());
+        total.unhookNs.insert(total.unhookNs.end(), result.unhookNs.begin(), result.unhookNs.end());
+        total.wrongResults  += result.wrongResults;
+        total.failedHooks   += result.failedHooks;
+        total.failedUnhooks += result.failedUnhooks;
+    }
+    std::printf("%zu threads, %lld ms\n", threadCount, (long long)duration.count());
+    printPercentiles("call", total.callNs);
+    printPercentiles("hook", total.hookNs);
+    printPercentiles("unhook", total.unhookNs);
+    GLACIE_CHECK(!total.hookNs.empty());
+    GLACIE_CHECK(total.wrongResults == 0);
+    GLACIE_CHECK(total.failedHooks == 0);
+    GLACIE_CHECK(total.failedUnhooks == 0);
+
+    // every detour is gone, after the grace period each prologue is the original again
+    synchronizeEpoch();
+    for (size_t i = 0; i < TARGET_COUNT; ++i) {
+        GLACIE_CHECK(getTarget(i)(7) == 8);
+        GLACIE_CHECK(memcmp(original, (void*)getTarget(i), sizeof(original)) == 0);
+    }
+    return glacie::test::getTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "glacie/memory/Epoch.h"
+#include "glacie/memory/Hook.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "../bench/Bench.h"
+#include "Test.h"
+
+// Hooks and unhooks targets of every live patch kind while other threads call them, checks every result and
+// prints how long the callers were held up. Arguments: [threads] [cycles].
+
+using namespace glacie::memory;
+using namespace glacie::bench;
+
+// an atomic target whose first instruction takes the whole jump, a hot-patch target preceded by padding
+// with a 2 byte first instruction, and one which allows neither
+extern "C" int glacieLivePatchAtomic(int value);
+extern "C" int glacieLivePatchHotPatch(int value);
+extern "C" int glacieLivePatchNeither(int value);
+asm(R"(
+.text
+.p2align 4
+.globl glacieLivePatchAtomic
+glacieLivePatchAtomic:
+    mov $1000, %eax
+    add %edi, %eax
+    ret
+.p2align 4
+    .skip 11, 0x90
+    .skip 5, 0xCC
+.globl glacieLivePatchHotPatch
+glacieLivePatchHotPatch:
+    lea 1(%rdi), %eax
+    ret
+    nop
+    nop
+.p2align 4
+    .skip 15, 0x90
+.globl glacieLivePatchNeither
+glacieLivePatchNeither:
+    push %rbx
+    lea 2(%rdi), %eax
+    pop %rbx
+    ret
+)");
+
+GLACIE_STATIC_HOOK(LivePatchAtomicHook, &glacieLivePatchAtomic, int, int value) { return origin(value) + 1; }
+GLACIE_STATIC_HOOK(LivePatchHotPatchHook, &glacieLivePatchHotPatch, int, int value) { return origin(value) + 1; }
+GLACIE_STATIC_HOOK(LivePatchNeitherHook, &glacieLivePatchNeither, int, int value) { return origin(value) + 1; }
+
+namespace {
+
+constexpr size_t    PROLOGUE_SIZE = 8;
+constexpr ptrdiff_t PADDING_SIZE  = 5;
+
+uint8_t const* getCode(int (*function)(int), ptrdiff_t offset = 0) {
+    return (uint8_t const*)((uintptr_t)function + offset);
+}
+
+struct CallerResult {
+    uint64_t              calls{};
+    uint64_t              wrongResults{};
+    std::vector<uint64_t> gapNs; // the longest time between two calls in each slice of the run
+};
+
+std::atomic_bool stopCallers{};
+
+uint64_t getElapsedNs(std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count();
+}
+
+void runCaller(CallerResult& result) {
+    int (*volatile atomic)(int)   = &glacieLivePatchAtomic;
+    int (*volatile hotPatch)(int) = &glacieLivePatchHotPatch;
+    auto     last                 = std::chrono::steady_clock::now();
+    uint64_t gap                  = 0;
+    for (int value = 0; !stopCallers.load(std::memory_order_relaxed); value = (value + 1) & 0xFFFF) {
+        auto first  = atomic(value);
+        auto second = hotPatch(value);
+        if (first != value + 1000 && first != value + 1001) ++result.wrongResults;
+        if (second != value + 1 && second != value + 2) ++result.wrongResults;
+        auto now = std::chrono::steady_clock::now();
+        gap      = std::max(gap, getElapsedNs(last, now));
+        last     = now;
+        if (++result.calls % 4096 == 0) {
+            result.gapNs.push_back(gap);
+            gap = 0;
+        }
+    }
+}
+
+void printPercentiles(char const* name, std::vector<uint64_t>& samples) {
+    std::printf(
+        "%-24s p50 %8llu  p99 %8llu  max %8llu ns\n",
+        name,
+        (unsigned long long)getPercentile(samples, 0.5),
+        (unsigned long long)getPercentile(samples, 0.99),
+        (unsigned long long)getPercentile(samples, 1.0)
+    );
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t threadCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4;
+    int    cycles      = argc > 2 ? std::atoi(argv[2]) : 2000;
+    threadCount        = std::max<size_t>(threadCount, 1);
+
+    uint8_t atomicPrologue[PROLOGUE_SIZE], hotPatchPrologue[PROLOGUE_SIZE], hotPatchPadding[PADDING_SIZE];
+    memcpy(atomicPrologue, getCode(&glacieLivePatchAtomic), PROLOGUE_SIZE);
+    memcpy(hotPatchPrologue, getCode(&glacieLivePatchHotPatch), PROLOGUE_SIZE);
+    memcpy(hotPatchPadding, getCode(&glacieLivePatchHotPatch, -PADDING_SIZE), PADDING_SIZE);
+
+    setLivePatching(true);
+    // a push is too short for an atomic jump and there is no padding to put one into
+    GLACIE_CHECK(LivePatchNeitherHook::hook() != 0);
+    GLACIE_CHECK(glacieLivePatchNeither(5) == 7);
+
+    std::vector<CallerResult> results(threadCount);
+    std::vector<std::thread>  callers;
+    for (auto& result : results) callers.emplace_back(runCaller, std::ref(result));
+    std::vector<uint64_t> hookNs, unhookNs;
+    int                   failures = 0;
+    for (int i = 0; i < cycles; ++i) {
+        auto begin = std::chrono::steady_clock::now();
+        failures   += LivePatchAtomicHook::hook() != 0;
+        failures   += LivePatchHotPatchHook::hook() != 0;
+        auto middle = std::chrono::steady_clock::now();
+        failures   += !LivePatchAtomicHook::unhook();
+        failures   += !LivePatchHotPatchHook::unhook();
+        synchronizeEpoch();
+        hookNs.push_back(getElapsedNs(begin, middle));
+        unhookNs.push_back(getElapsedNs(middle, std::chrono::steady_clock::now()));
+    }
+    stopCallers = true;
+    for (auto& caller : callers) caller.join();
+    setLivePatching(false);
+
+    CallerResult total;
+    for (auto& result : results) {
+        total.calls        += result.calls;
+        total.wrongResults += result.wrongResults;
+        total.gapNs.insert(total.gapNs.end(), result.gapNs.begin(), result.gapNs.end());
+    }
+    std::printf("%zu callers, %d cycles, %llu calls\n", threadCount, cycles, (unsigned long long)total.calls);
+    printPercentiles("caller pause", total.gapNs);
+    printPercentiles("hook", hookNs);
+    printPercentiles("unhook and grace period", unhookNs);
+    GLACIE_CHECK(failures == 0);
+    GLACIE_CHECK(total.wrongResults == 0);
+
+    // the entries are restored, the padding keeps its jump to the trampoline for threads which fetched it late
+    GLACIE_CHECK(glacieLivePatchAtomic(5) == 1005 && glacieLivePatchHotPatch(5) == 6);
+    GLACIE_CHECK(memcmp(atomicPrologue, getCode(&glacieLivePatchAtomic), PROLOGUE_SIZE) == 0);
+    GLACIE_CHECK(memcmp(hotPatchPrologue, getCode(&glacieLivePatchHotPatch), PROLOGUE_SIZE) == 0);
+    GLACIE_CHECK(memcmp(hotPatchPadding, getCode(&glacieLivePatchHotPatch, -PADDING_SIZE), PADDING_SIZE) != 0);
+
+    // without live patching a plain jump is written, which is only safe since no other thread runs the target
+    GLACIE_CHECK(LivePatchNeitherHook::hook() == 0);
+    GLACIE_CHECK(glacieLivePatchNeither(5) == 8);
+    GLACIE_CHECK(LivePatchNeitherHook::unhook());
+    synchronizeEpoch();
+    GLACIE_CHECK(glacieLivePatchNeither(5) == 7);
+    return glacie::test::getTestResult();
+}
\ No newline at end of file
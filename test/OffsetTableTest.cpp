@@ -0,0 +1,66 @@
+#include "glacie/memory/Memory.h"
+#include "glacie/memory/OffsetTable.h"
+#include "glacie/memory/SymbolIndex.h"
+
+#include <cstdint>
+
+#include "Test.h"
+
+using namespace glacie::memory;
+
+// two functions which the test executable, as the server, contains once each
+extern "C" int glacieOffsetTableScanned(int value);
+extern "C" int glacieOffsetTableListed(int value);
+asm(R"(
+.text
+.p2align 4
+.globl glacieOffsetTableScanned
+glacieOffsetTableScanned:
+    mov $0x5A17C0DE, %eax
+    add %edi, %eax
+    ret
+.p2align 4
+.globl glacieOffsetTableListed
+glacieOffsetTableListed:
+    mov $0x5A17C0DF, %eax
+    add %edi, %eax
+    ret
+)");
+
+namespace {
+
+constexpr char SCANNED_SIGNATURE[] = "B8 DE C0 17 5A 01 F8 C3";
+constexpr char LISTED_SIGNATURE[]  = "B8 DF C0 17 5A 01 F8 C3";
+
+// the table claims that the first signature is found at the second function
+OffsetEntry offsets[] = {
+    {SCANNED_SIGNATURE, 0},
+};
+
+} // namespace
+
+int main() {
+    // nothing is registered yet, so the signature is scanned
+    GLACIE_CHECK(findOffsetTable(SCANNED_SIGNATURE) == nullptr);
+    GLACIE_CHECK(resolveSignature(SCANNED_SIGNATURE) == (FuncPtr)&glacieOffsetTableScanned);
+
+    auto fingerprint = getServerFingerprint();
+    auto base        = getServerBase();
+    GLACIE_CHECK(fingerprint.has_value() && base.has_value());
+    if (!fingerprint || !base) { return glacie::test::getTestResult(); }
+    offsets[0].rva = (uintptr_t)&glacieOffsetTableListed - *base;
+
+    // a table of another build is ignored
+    GLACIE_CHECK(!registerOffsetTable(*fingerprint + 1, offsets));
+    GLACIE_CHECK(findOffsetTable(SCANNED_SIGNATURE) == nullptr);
+
+    // the base is 0 if the test is not linked as PIE, which is as valid as any other
+    GLACIE_CHECK(registerOffsetTable(*fingerprint, offsets));
+    GLACIE_CHECK(findOffsetTable(SCANNED_SIGNATURE) == (FuncPtr)&glacieOffsetTableListed);
+    GLACIE_CHECK(resolveSignature(SCANNED_SIGNATURE) == (FuncPtr)&glacieOffsetTableListed);
+
+    // signatures which are not in the table are still scanned
+    GLACIE_CHECK(findOffsetTable(LISTED_SIGNATURE) == nullptr);
+    GLACIE_CHECK(resolveSignature(LISTED_SIGNATURE) == (FuncPtr)&glacieOffsetTableListed);
+    return glacie::test::getTestResult();
+}
\ No newline at end of file
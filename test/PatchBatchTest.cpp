@@ -0,0 +1,125 @@
+#include "glacie/memory/PatchBatch.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Test.h"
+
+using namespace glacie::memory;
+
+namespace {
+
+// the protection of the mapping which contains address, as the kernel reports it
+int getProtection(void const* address) {
+    FILE* file = fopen("/proc/self/maps", "r");
+    if (!file) { return -1; }
+    char line[512];
+    int  result = -1;
+    while (fgets(line, sizeof(line), file)) {
+        char*     next;
+        uintptr_t begin = strtoull(line, &next, 16);
+        uintptr_t end   = strtoull(next + 1, &next, 16);
+        if ((uintptr_t)address < begin || (uintptr_t)address >= end) { continue; }
+        result = PROT_NONE;
+        if (next[1] == 'r') result |= PROT_READ;
+        if (next[2] == 'w') result |= PROT_WRITE;
+        if (next[3] == 'x') result |= PROT_EXEC;
+        break;
+    }
+    fclose(file);
+    return result;
+}
+
+uint8_t* mapPages(size_t count, int prot) {
+    auto pages = mmap(nullptr, count * getpagesize(), prot, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    return pages == MAP_FAILED ? nullptr : (uint8_t*)pages;
+}
+
+void testWritesOnOnePage() {
+    auto page = mapPages(1, PROT_READ | PROT_EXEC);
+    GLACIE_CHECK(page != nullptr);
+    PatchBatch batch;
+    batch.add(page + 16, {0x01, 0x02, 0x03}).add(page + 512, {0xC3}).fill(page + 1024, 0x90, 6);
+    GLACIE_CHECK(batch.size() == 3);
+    GLACIE_CHECK(batch.commit());
+    GLACIE_CHECK(page[16] == 0x01 && page[17] == 0x02 && page[18] == 0x03);
+    GLACIE_CHECK(page[512] == 0xC3);
+    GLACIE_CHECK(page[1024] == 0x90 && page[1029] == 0x90 && page[1030] == 0);
+    GLACIE_CHECK(getProtection(page) == (PROT_READ | PROT_EXEC));
+    munmap(page, getpagesize());
+}
+
+void testWritesSpanningPages() {
+    auto pageSize = (size_t)getpagesize();
+    auto pages    = mapPages(3, PROT_READ);
+    GLACIE_CHECK(pages != nullptr);
+    PatchBatch batch;
+    // one write across the first boundary and a fill over the whole middle page into the last one
+    batch.add(pages + pageSize - 2, {0xAA, 0xBB, 0xCC, 0xDD});
+    batch.fill(pages + pageSize + 8, 0xCC, pageSize + 8);
+    GLACIE_CHECK(batch.commit());
+    GLACIE_CHECK(pages[pageSize - 2] == 0xAA && pages[pageSize + 1] == 0xDD);
+    GLACIE_CHECK(pages[pageSize + 8] == 0xCC && pages[2 * pageSize + 15] == 0xCC && pages[2 * pageSize + 16] == 0);
+    for (size_t i = 0; i < 3; ++i) GLACIE_CHECK(getProtection(pages + i * pageSize) == PROT_READ);
+    munmap(pages, 3 * pageSize);
+}
+
+void testOriginalProtectionRestored() {
+    auto pageSize = (size_t)getpagesize();
+    auto pages    = mapPages(3, PROT_READ | PROT_EXEC);
+    GLACIE_CHECK(pages != nullptr);
+    mprotect(pages + pageSize, pageSize, PROT_READ);
+    mprotect(pages + 2 * pageSize, pageSize, PROT_READ | PROT_WRITE);
+    PatchBatch batch;
+    for (size_t i = 0; i < 3; ++i) batch.add(pages + i * pageSize + 32, {(uint8_t)(i + 1)});
+    GLACIE_CHECK(batch.commit());
+    for (size_t i = 0; i < 3; ++i) GLACIE_CHECK(pages[i * pageSize + 32] == i + 1);
+    GLACIE_CHECK(getProtection(pages) == (PROT_READ | PROT_EXEC));
+    GLACIE_CHECK(getProtection(pages + pageSize) == PROT_READ);
+    GLACIE_CHECK(getProtection(pages + 2 * pageSize) == (PROT_READ | PROT_WRITE));
+    munmap(pages, 3 * pageSize);
+}
+
+void testCallback() {
+    auto pageSize = (size_t)getpagesize();
+    auto pages    = mapPages(2, PROT_READ);
+    GLACIE_CHECK(pages != nullptr);
+    bool called = false;
+    PatchBatch batch;
+    batch.add(pages, {0x11}).touch(pages + pageSize, 4);
+    bool committed = batch.commit([&] {
+        called = true;
+        // the queued writes are applied before the callback, and the touched region is writable
+        GLACIE_CHECK(pages[0] == 0x11);
+        GLACIE_CHECK(getProtection(pages + pageSize) & PROT_WRITE);
+        memset(pages + pageSize, 0x22, 4);
+    });
+    GLACIE_CHECK(committed && called);
+    GLACIE_CHECK(pages[pageSize] == 0x22 && pages[pageSize + 3] == 0x22);
+    GLACIE_CHECK(getProtection(pages + pageSize) == PROT_READ);
+
+    // a page which is not mapped fails the whole batch before anything is written
+    munmap(pages + pageSize, pageSize);
+    called = false;
+    PatchBatch failing;
+    failing.add(pages + 1, {0x33}).add(pages + pageSize, {0x44});
+    GLACIE_CHECK(!failing.commit([&] { called = true; }));
+    GLACIE_CHECK(!called && pages[1] == 0);
+    GLACIE_CHECK(getProtection(pages) == PROT_READ);
+    munmap(pages, pageSize);
+}
+
+} // namespace
+
+int main() {
+    testWritesOnOnePage();
+    testWritesSpanningPages();
+    testOriginalProtectionRestored();
+    testCallback();
+    return glacie::test::getTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include "glacie/memory/Patch.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Test.h"
+
+using namespace glacie::memory;
+
+namespace {
+
+constexpr size_t CODE_SIZE = 64;
+
+// a page of code which is not writable, as the code of the server
+uint8_t* mapCode() {
+    auto page = mmap(nullptr, getpagesize(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (page == MAP_FAILED) { return nullptr; }
+    for (size_t i = 0; i < CODE_SIZE; ++i) ((uint8_t*)page)[i] = (uint8_t)(0x40 + i);
+    mprotect(page, getpagesize(), PROT_READ | PROT_EXEC);
+    return (uint8_t*)page;
+}
+
+// whether code matches the original bytes, except for bytes at offset
+bool hasBytes(uint8_t const* code, size_t offset = 0, std::span<uint8_t const> bytes = {}) {
+    for (size_t i = 0; i < CODE_SIZE; ++i) {
+        auto expected = i >= offset && i < offset + bytes.size() ? bytes[i - offset] : (uint8_t)(0x40 + i);
+        if (code[i] != expected) { return false; }
+    }
+    return true;
+}
+
+constexpr std::array<uint8_t, 4> PATCH_BYTES{0x90, 0x90, 0xEB, 0x05};
+constexpr std::array<uint8_t, 2> OTHER_BYTES{0xB0, 0x01};
+
+// both patches of testGroup are written and nothing else
+bool hasGroupBytes(uint8_t const* code) {
+    uint8_t expected[CODE_SIZE];
+    for (size_t i = 0; i < CODE_SIZE; ++i) expected[i] = (uint8_t)(0x40 + i);
+    memcpy(expected + 8, PATCH_BYTES.data(), PATCH_BYTES.size());
+    memcpy(expected + 32, OTHER_BYTES.data(), OTHER_BYTES.size());
+    return memcmp(code, expected, CODE_SIZE) == 0;
+}
+
+void testToggle(uint8_t* code) {
+    auto id = registerPatch(code + 16, PATCH_BYTES);
+    GLACIE_CHECK(id >= 0 && isPatchEnabled(id));
+    GLACIE_CHECK(hasBytes(code, 16, PATCH_BYTES));
+
+    // regions which overlap the start, the end or all of the patch are rejected, adjacent ones are not
+    GLACIE_CHECK(registerPatch(code + 15, OTHER_BYTES) == -1);
+    GLACIE_CHECK(registerPatch(code + 19, OTHER_BYTES) == -1);
+    GLACIE_CHECK(registerPatch(code + 12, std::array<uint8_t, 12>{}) == -1);
+    GLACIE_CHECK(hasBytes(code, 16, PATCH_BYTES));
+    auto before = registerPatch(code + 14, OTHER_BYTES, false);
+    auto after  = registerPatch(code + 20, OTHER_BYTES, false);
+    GLACIE_CHECK(before >= 0 && after >= 0 && !isPatchEnabled(before) && !isPatchEnabled(after));
+    GLACIE_CHECK(hasBytes(code, 16, PATCH_BYTES));
+    GLACIE_CHECK(removePatch(before) && removePatch(after));
+
+    for (int i = 0; i < 2; ++i) {
+        GLACIE_CHECK(disablePatch(id) && !isPatchEnabled(id));
+        GLACIE_CHECK(hasBytes(code));
+        GLACIE_CHECK(disablePatch(id) && hasBytes(code));
+        GLACIE_CHECK(enablePatch(id) && isPatchEnabled(id));
+        GLACIE_CHECK(hasBytes(code, 16, PATCH_BYTES));
+    }
+
+    // an unknown id fails the whole call without changing the others
+    int const ids[] = {id, id + 1000};
+    GLACIE_CHECK(!setPatchesEnabled(ids, false));
+    GLACIE_CHECK(isPatchEnabled(id) && hasBytes(code, 16, PATCH_BYTES));
+
+    GLACIE_CHECK(removePatch(id));
+    GLACIE_CHECK(!removePatch(id) && !isPatchEnabled(id));
+    GLACIE_CHECK(hasBytes(code));
+
+    // the region is free again
+    id = registerPatch(code + 16, PATCH_BYTES, false);
+    GLACIE_CHECK(id >= 0 && hasBytes(code));
+    GLACIE_CHECK(removePatch(id) && hasBytes(code));
+}
+
+void testGroup(uint8_t* code) {
+    {
+        PatchGroup group;
+        GLACIE_CHECK(group.add(code + 8, PATCH_BYTES));
+        GLACIE_CHECK(group.add(code + 32, OTHER_BYTES, false));
+        GLACIE_CHECK(!group.add(code + 9, OTHER_BYTES));
+        GLACIE_CHECK(group.getIds().size() == 2);
+        GLACIE_CHECK(hasBytes(code, 8, PATCH_BYTES));
+
+        for (int i = 0; i < 2; ++i) {
+            GLACIE_CHECK(group.enable());
+            GLACIE_CHECK(hasGroupBytes(code));
+            GLACIE_CHECK(group.disable());
+            GLACIE_CHECK(hasBytes(code));
+        }
+        GLACIE_CHECK(group.enable());
+
+        // the patches move with the group
+        PatchGroup moved = std::move(group);
+        GLACIE_CHECK(group.getIds().empty() && moved.getIds().size() == 2);
+        GLACIE_CHECK(hasGroupBytes(code));
+    }
+    // destroying the group removes its patches and restores the bytes
+    GLACIE_CHECK(hasBytes(code));
+    auto id = registerPatch(code + 8, PATCH_BYTES, false);
+    GLACIE_CHECK(id >= 0 && removePatch(id));
+}
+
+} // namespace
+
+int main() {
+    auto code = mapCode();
+    GLACIE_CHECK(code != nullptr);
+    if (!code) { return glacie::test::getTestResult(); }
+    testToggle(code);
+    testGroup(code);
+    munmap(code, getpagesize());
+    return glacie::test::getTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,84 @@
+#include "glacie/memory/Epoch.h"
+#include "glacie/memory/Probe.h"
+
+#include <cstdarg>
+#include <cstdio>
+
+#include "Test.h"
+
+using namespace glacie::memory;
+
+// returns value + 1, the 5 byte first instruction lets the prologue be replaced by a single store
+extern "C" int glacieProbeTestTarget(int value);
+asm(R"(
+.text
+.p2align 4
+.globl glacieProbeTestTarget
+glacieProbeTestTarget:
+    mov $1, %eax
+    add %edi, %eax
+    ret
+.p2align 4
+.globl glacieProbeTestOther
+glacieProbeTestOther:
+    mov $2, %eax
+    add %edi, %eax
+    ret
+)");
+extern "C" int glacieProbeTestOther(int value);
+
+namespace {
+
+// al carries the number of vector registers of a variadic call, the probe must pass it on
+[[gnu::noinline]] double sumVariadic(int count, ...) {
+    va_list args;
+    va_start(args, count);
+    double sum = 0;
+    for (int i = 0; i < count; ++i) sum += va_arg(args, double);
+    va_end(args);
+    return sum;
+}
+
+uint64_t getCalls(int id) {
+    for (auto& stats : getProbeStats()) {
+        if (stats.id == id) { return stats.calls; }
+    }
+    return 0;
+}
+
+} // namespace
+
+int main() {
+    int (*volatile target)(int) = &glacieProbeTestTarget;
+    int (*volatile other)(int)  = &glacieProbeTestOther;
+
+    auto id = addProbe((FuncPtr)&glacieProbeTestTarget, "target");
+    GLACIE_CHECK(id >= 0);
+    GLACIE_CHECK(addProbe((FuncPtr)&glacieProbeTestTarget, "again") == -1);
+    for (int i = 0; i < 10; ++i) GLACIE_CHECK(target(i) == i + 1);
+    GLACIE_CHECK(getCalls(id) == 10);
+
+    // the id stays with the function, another function never counts into it
+    GLACIE_CHECK(removeProbe(id));
+    GLACIE_CHECK(!removeProbe(id));
+    GLACIE_CHECK(target(1) == 2);
+    auto otherId = addProbe((FuncPtr)&glacieProbeTestOther, "other");
+    GLACIE_CHECK(otherId >= 0 && otherId != id);
+    GLACIE_CHECK(other(1) == 3);
+    GLACIE_CHECK(getCalls(otherId) == 1);
+    GLACIE_CHECK(addProbe((FuncPtr)&glacieProbeTestTarget, "target") == id);
+    GLACIE_CHECK(target(2) == 3);
+    GLACIE_CHECK(getCalls(id) == 1);
+
+    double (*volatile variadic)(int, ...) = &sumVariadic;
+    auto variadicId                       = addProbe((FuncPtr)&sumVariadic, "variadic");
+    GLACIE_CHECK(variadicId >= 0);
+    GLACIE_CHECK(variadic(3, 1.0, 2.0, 3.5) == 6.5);
+    GLACIE_CHECK(getCalls(variadicId) == 1);
+
+    removeAllProbes();
+    synchronizeEpoch();
+    GLACIE_CHECK(getProbeStats().empty());
+    GLACIE_CHECK(target(3) == 4 && other(3) == 5 && variadic(2, 1.0, 1.0) == 2.0);
+    return glacie::test::getTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include "glacie/utils/StringUtils.h"
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Test.h"
+
+using namespace glacie::utils::string_utils;
+
+int main() {
+    GLACIE_CHECK(replaceAll(std::string_view{"a-b-c"}, "-", "--") == "a--b--c");
+    GLACIE_CHECK(replaceAll(std::string_view{"a--b--c"}, "--", "") == "abc");
+    GLACIE_CHECK(replaceAll(std::string_view{"abc"}, "", "x") == "abc");
+    std::string str = "x-y-z";
+    GLACIE_CHECK(replaceAll(str, "-", "_") == "x_y_z");
+
+    MultiReplacer const escaper{
+        {"&", "&amp;"},
+        {"<", "&lt;" },
+        {">", "&gt;" },
+    };
+    GLACIE_CHECK(escaper("<a & b>") == "&lt;a &amp; b&gt;");
+    // the longest pattern wins, and a replacement is not matched again
+    GLACIE_CHECK(MultiReplacer({{"a", "b"}, {"ab", "c"}, {"b", "a"}})("abba") == "cab");
+    // of duplicated patterns the first entry of the table wins, also in tables too long for an insertion sort
+    std::vector<std::string>                                   values;
+    std::vector<std::pair<std::string_view, std::string_view>> table;
+    for (int i = 0; i < 64; ++i) values.push_back(std::to_string(i));
+    for (auto& value : values) table.emplace_back(value.size() == 1 ? "k" : "j", value);
+    GLACIE_CHECK(MultiReplacer{table}("kj") == "010");
+    return glacie::test::getTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#include "glacie/memory/SymbolIndex.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "Test.h"
+
+using namespace glacie::memory;
+
+extern "C" [[gnu::noinline, gnu::used]] int glacieSymbolIndexTestTarget(int value) { return value * 3; }
+
+// an absolute symbol is no address of the image and must not be indexed
+asm(R"(
+.globl glacieSymbolIndexTestAbsolute
+.set glacieSymbolIndexTestAbsolute, 0x1234
+)");
+
+namespace {
+
+// the layout written by SymbolIndex::build
+constexpr size_t HEADER_SIZE       = 24;
+constexpr size_t HEADER_COUNT      = 12;
+constexpr size_t HEADER_SLOT_COUNT = 16;
+constexpr size_t SLOT_SIZE         = 24;
+constexpr size_t SLOT_NAME_SIZE    = 20;
+
+uint64_t getSlotCount(std::vector<uint8_t> const& index) {
+    uint64_t slotCount;
+    memcpy(&slotCount, index.data() + HEADER_SLOT_COUNT, sizeof(slotCount));
+    return slotCount;
+}
+
+void testBuildAndFind() {
+    std::vector<SymbolEntry> entries{
+        {"?foo@@YAXXZ",    0x1000},
+        {"?bar@@YAHH@Z",   0x2000},
+        {"?foo@@YAXXZ",    0x3000},
+        {"",               0x4000},
+        {"_ZN3baz4quuxEv", 0x5000},
+    };
+    SymbolIndex index;
+    GLACIE_CHECK(index.load(SymbolIndex::build(entries)));
+    GLACIE_CHECK(index.size() == 3);
+    // duplicated names keep the first entry, empty names are skipped
+    GLACIE_CHECK(index.find("?foo@@YAXXZ") == 0x1000);
+    GLACIE_CHECK(index.find("?bar@@YAHH@Z") == 0x2000);
+    GLACIE_CHECK(index.find("_ZN3baz4quuxEv") == 0x5000);
+    GLACIE_CHECK(!index.find("?missing@@YAXXZ"));
+    GLACIE_CHECK(!index.find(""));
+
+    auto  path = (std::filesystem::temp_directory_path() / "glacie-symbol-index-test.symidx").string();
+    auto  data = SymbolIndex::build(entries);
+    FILE* file = fopen(path.c_str(), "wb");
+    GLACIE_CHECK(file && fwrite(data.data(), 1, data.size(), file) == data.size());
+    if (file) { fclose(file); }
+    SymbolIndex mapped;
+    GLACIE_CHECK(mapped.open(path));
+    GLACIE_CHECK(mapped.find("?bar@@YAHH@Z") == 0x2000);
+    mapped.close();
+    std::filesystem::remove(path);
+}
+
+void testCorruptIndex() {
+    std::vector<SymbolEntry> entries{
+        {"first",  1},
+        {"second", 2},
+    };
+    auto data      = SymbolIndex::build(entries);
+    auto slotCount = getSlotCount(data);
+
+    // a header claiming as many symbols as slots leaves no empty slot to stop the probing
+    auto full  = data;
+    auto count = (uint32_t)slotCount;
+    memcpy(full.data() + HEADER_COUNT, &count, sizeof(count));
+    SymbolIndex index;
+    GLACIE_CHECK(!index.load(full));
+
+    // every slot taken while the header still looks valid, a missing name has to end the lookup
+    auto occupied = data;
+    for (uint64_t i = 0; i < slotCount; ++i) {
+        auto     nameSize = occupied.data() + HEADER_SIZE + i * SLOT_SIZE + SLOT_NAME_SIZE;
+        uint32_t value;
+        memcpy(&value, nameSize, sizeof(value));
+        if (value == 0) {
+            value = 1;
+            memcpy(nameSize, &value, sizeof(value));
+        }
+    }
+    GLACIE_CHECK(index.load(occupied));
+    GLACIE_CHECK(!index.find("missing"));
+    GLACIE_CHECK(index.find("second") == 2);
+
+    auto truncated = data;
+    truncated.resize(HEADER_SIZE + SLOT_SIZE);
+    GLACIE_CHECK(!index.load(truncated));
+}
+
+void testElfSymbols() {
+    auto entries = SymbolIndex::readElfSymbols(getServerPath().string());
+    GLACIE_CHECK(!entries.empty());
+    auto findEntry = [&](std::string_view name) {
+        return std::find_if(entries.begin(), entries.end(), [&](auto const& entry) { return entry.name == name; });
+    };
+    auto target = findEntry("glacieSymbolIndexTestTarget");
+    GLACIE_CHECK(target != entries.end());
+    GLACIE_CHECK(findEntry("glacieSymbolIndexTestAbsolute") == entries.end());
+
+    // the RVA is relative to the load bias of the executable
+    auto base = getServerBase();
+    GLACIE_CHECK(base.has_value());
+    if (target != entries.end() && base) {
+        GLACIE_CHECK(*base + target->rva == (uintptr_t)&glacieSymbolIndexTestTarget);
+    }
+
+    SymbolIndex index;
+    GLACIE_CHECK(index.load(SymbolIndex::build(entries)));
+    if (target != entries.end()) { GLACIE_CHECK(index.find("glacieSymbolIndexTestTarget") == target->rva); }
+
+    // the index of the server is built from the executable on the first lookup
+    auto resolved = (int (*)(int))resolveSymbol("glacieSymbolIndexTestTarget");
+    GLACIE_CHECK(resolved == &glacieSymbolIndexTestTarget);
+    if (resolved) { GLACIE_CHECK(resolved(5) == 15); }
+    GLACIE_CHECK(resolveSymbol("glacieSymbolIndexTestAbsolute") == nullptr);
+}
+
+} // namespace
+
+int main() {
+    testBuildAndFind();
+    testCorruptIndex();
+    testElfSymbols();
+    return glacie::test::getTestResult();
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstdio>
+
+namespace glacie::test {
+
+inline int failureCount{};
+
+// the exit code of a test, non-zero if a check failed
+[[nodiscard]] inline int getTestResult() {
+    if (failureCount) { std::fprintf(stderr, "%d check(s) failed\n", failureCount); }
+    return failureCount ? 1 : 0;
+}
+
+} // namespace glacie::test
+
+#define GLACIE_CHECK(...)                                                                                              \
+    do {                                                                                                               \
+        if (!(__VA_ARGS__)) {                                                                                          \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #__VA_ARGS__);                       \
+            ++::glacie::test::failureCount;                                                                            \
+        }                                                                                                              \
+    } while (0)
@@ -0,0 +1,135 @@
+#define GLACIE_HOOK_TRACE
+
+#include "glacie/memory/Hook.h"
+#include "glacie/memory/Trace.h"
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Test.h"
+
+using namespace glacie::memory;
+
+// two functions returning value + 1, the detour of the outer one calls the inner one
+extern "C" int glacieTraceTestOuter(int value);
+extern "C" int glacieTraceTestInner(int value);
+asm(R"(
+.text
+.p2align 4
+.globl glacieTraceTestOuter
+glacieTraceTestOuter:
+    mov $1, %eax
+    add %edi, %eax
+    ret
+.p2align 4
+.globl glacieTraceTestInner
+glacieTraceTestInner:
+    mov $1, %eax
+    add %edi, %eax
+    ret
+)");
+
+int (*volatile traceTestInner)(int) = &glacieTraceTestInner;
+
+GLACIE_STATIC_HOOK(TraceOuterHook, &glacieTraceTestOuter, int, int value) { return origin(traceTestInner(value)); }
+GLACIE_STATIC_HOOK(TraceInnerHook, &glacieTraceTestInner, int, int value) { return origin(value); }
+
+namespace {
+
+constexpr int CALLS_PER_THREAD = 1000;
+
+struct TraceEvent {
+    std::string name;
+    char        phase{};
+    double      ts{};
+    uint64_t    tid{};
+};
+
+// only reads what convertTraceToChromeJson writes, one object per event without nesting
+std::vector<TraceEvent> readEvents(std::string const& json) {
+    std::vector<TraceEvent> result;
+    for (auto pos = json.find(R"({"name":")"); pos != std::string::npos; pos = json.find(R"({"name":")", pos + 1)) {
+        TraceEvent event;
+        auto       nameBegin = pos + 9;
+        auto       nameEnd   = json.find('"', nameBegin);
+        auto       phase     = json.find(R"("ph":")", nameEnd);
+        auto       ts        = json.find(R"("ts":)", nameEnd);
+        auto       tid       = json.find(R"("tid":)", nameEnd);
+        if (nameEnd == std::string::npos || phase == std::string::npos || ts == std::string::npos
+            || tid == std::string::npos) {
+            break;
+        }
+        event.name  = json.substr(nameBegin, nameEnd - nameBegin);
+        event.phase = json[phase + 6];
+        event.ts    = std::stod(json.substr(ts + 5));
+        event.tid   = std::stoull(json.substr(tid + 6));
+        result.push_back(std::move(event));
+    }
+    return result;
+}
+
+} // namespace
+
+int main() {
+    GLACIE_CHECK(!stopHookTrace());
+    GLACIE_CHECK(TraceOuterHook::hook() == 0);
+    GLACIE_CHECK(TraceInnerHook::hook() == 0);
+
+    auto tracePath = (std::filesystem::temp_directory_path() / "GlacieTraceTest.trace").string();
+    auto jsonPath  = (std::filesystem::temp_directory_path() / "GlacieTraceTest.json").string();
+    GLACIE_CHECK(startHookTrace(tracePath));
+    GLACIE_CHECK(!startHookTrace(tracePath));
+    std::atomic_int          wrongResults{};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 2; ++i) {
+        threads.emplace_back([&] {
+            int (*volatile outer)(int) = &glacieTraceTestOuter;
+            for (int value = 0; value < CALLS_PER_THREAD; ++value) wrongResults += outer(value) != value + 2;
+        });
+    }
+    for (auto& thread : threads) thread.join();
+    GLACIE_CHECK(wrongResults == 0);
+    GLACIE_CHECK(stopHookTrace());
+    GLACIE_CHECK(TraceOuterHook::unhook() && TraceInnerHook::unhook());
+
+    GLACIE_CHECK(convertTraceToChromeJson(tracePath, jsonPath));
+    std::ifstream file(jsonPath);
+    std::string   json{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    GLACIE_CHECK(json.find(R"("droppedRecords":0)") != std::string::npos);
+
+    // every call of each thread is B outer, B inner, E inner, E outer, in the order of the thread
+    auto                                         events = readEvents(json);
+    std::map<uint64_t, std::vector<TraceEvent*>> stacks;
+    std::map<uint64_t, int>                      calls;
+    std::map<uint64_t, double>                   lastTs;
+    int                                          mismatches = 0;
+    for (auto& event : events) {
+        auto& stack = stacks[event.tid];
+        if (lastTs.contains(event.tid) && event.ts < lastTs[event.tid]) { ++mismatches; }
+        lastTs[event.tid] = event.ts;
+        if (event.phase == 'B') {
+            auto expected = stack.empty() ? "TraceOuterHook" : "TraceInnerHook";
+            if (event.name != expected || stack.size() > 1) { ++mismatches; }
+            stack.push_back(&event);
+        } else if (event.phase != 'E' || stack.empty() || stack.back()->name != event.name) {
+            ++mismatches;
+        } else {
+            stack.pop_back();
+            if (stack.empty()) { ++calls[event.tid]; }
+        }
+    }
+    GLACIE_CHECK(events.size() == 2 * 4 * CALLS_PER_THREAD);
+    GLACIE_CHECK(mismatches == 0);
+    GLACIE_CHECK(calls.size() == 2);
+    for (auto& [tid, count] : calls) GLACIE_CHECK(count == CALLS_PER_THREAD && stacks[tid].empty());
+
+    std::filesystem::remove(tracePath);
+    std::filesystem::remove(jsonPath);
+    return glacie::test::getTestResult();
+}
\ No newline at end of file
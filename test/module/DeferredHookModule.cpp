@@ -0,0 +1,13 @@
+// a module for DeferredHookTest which is only loaded by the test, its function returns value + 1
+extern "C" int glacieDeferredHookModuleTarget(int value);
+asm(R"(
+.text
+.p2align 4
+.globl glacieDeferredHookModuleTarget
+.type glacieDeferredHookModuleTarget, @function
+glacieDeferredHookModuleTarget:
+    mov $0x5A17D00D, %eax
+    sub $0x5A17D00C, %eax
+    add %edi, %eax
+    ret
+)");
\ No newline at end of file
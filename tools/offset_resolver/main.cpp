@@ -0,0 +1,81 @@
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "glacie/memory/OffsetTable.h"
+#include "glacie/utils/FileUtils.h"
+
+#include "fmt/format.h"
+
+// read one signature per line, empty lines and lines starting with '#' are skipped
+static std::vector<std::string> readManifest(std::string const& path) {
+    std::vector<std::string> result;
+    std::ifstream            file(path);
+    std::string              line;
+    while (std::getline(file, line)) {
+        std::string_view view  = line;
+        auto             begin = view.find_first_not_of(" \t");
+        if (begin == std::string_view::npos || view[begin] == '#') { continue; }
+        view = view.substr(begin, view.find_last_not_of(" \t\r") + 1 - begin);
+        result.emplace_back(view);
+    }
+    return result;
+}
+
+// usage: GlacieOffsetResolver <server binary> <manifest> <output header>
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s <server binary> <manifest> <output header>\n", argv[0]);
+        return 1;
+    }
+    glacie::utils::file_utils::MappedFile server(argv[1]);
+    if (!server.isOpen()) {
+        fprintf(stderr, "failed to open %s\n", argv[1]);
+        return 1;
+    }
+    auto fingerprint = glacie::memory::getImageFingerprint(server.getData());
+    if (!fingerprint) {
+        fprintf(stderr, "%s has no build fingerprint\n", argv[1]);
+        return 1;
+    }
+
+    int  missing = 0;
+    auto out     = fmt::memory_buffer();
+    fmt::format_to(
+        std::back_inserter(out),
+        "// Generated by GlacieOffsetResolver, do not edit.\n"
+        "#pragma once\n\n"
+        "#include \"glacie/memory/OffsetTable.h\"\n\n"
+        "namespace glacie::generated {{\n\n"
+        "inline constexpr uint64_t serverFingerprint = {:#018x};\n\n"
+        "inline constexpr glacie::memory::OffsetEntry serverOffsets[] = {{\n",
+        *fingerprint
+    );
+    for (auto& signature : readManifest(argv[2])) {
+        auto rva = glacie::memory::scanImageSignature(server.getData(), signature.c_str());
+        if (!rva) {
+            fprintf(stderr, "signature not found: %s\n", signature.c_str());
+            ++missing;
+            continue;
+        }
+        fmt::format_to(std::back_inserter(out), "    {{\"{}\", {:#x}}},\n", signature, *rva);
+    }
+    fmt::format_to(
+        std::back_inserter(out),
+        "}};\n\n"
+        "// call before the first signature is resolved, signatures resolved earlier are scanned as usual,\n"
+        "// the table is ignored by other server builds\n"
+        "inline bool registerServerOffsets() {{\n"
+        "    return glacie::memory::registerOffsetTable(serverFingerprint, serverOffsets);\n"
+        "}}\n\n"
+        "}} // namespace glacie::generated\n"
+    );
+    if (!glacie::utils::file_utils::writeFile(argv[3], {(uint8_t const*)out.data(), out.size()})) {
+        fprintf(stderr, "failed to write %s\n", argv[3]);
+        return 1;
+    }
+    printf("%s\n", argv[3]);
+    return missing ? 1 : 0;
+}
\ No newline at end of file
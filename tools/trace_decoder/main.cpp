@@ -0,0 +1,20 @@
+#include <cstdio>
+#include <string>
+
+#include "glacie/memory/Trace.h"
+
+// usage: GlacieTraceDecoder <trace file> [json file]
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <trace file> [json file]\n", argv[0]);
+        return 1;
+    }
+    std::string tracePath = argv[1];
+    std::string jsonPath  = argc > 2 ? argv[2] : tracePath + ".json";
+    if (!glacie::memory::convertTraceToChromeJson(tracePath, jsonPath)) {
+        fprintf(stderr, "failed to convert %s\n", tracePath.c_str());
+        return 1;
+    }
+    printf("%s\n", jsonPath.c_str());
+    return 0;
+}
\ No newline at end of file
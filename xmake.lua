@@ -2,50 +2,127 @@ add_rules("mode.debug", "mode.release")
 
 add_repositories("liteldev-repo https://github.com/LiteLDev/xmake-repo.git")
 
-if not has_config("vs_runtime") then
+if is_plat("windows") and not has_config("vs_runtime") then
     set_runtimes("MD")
 end
 
 add_requires("fmt 10.2.1")
 add_requires("magic_enum 0.9.7")
-add_requires("detours v4.0.1-xmake.1")
 add_requires("libhat 2024.9.22")
+if is_plat("windows") then
+    add_requires("detours v4.0.1-xmake.1")
+end
 
 target("GlacieHook")
     set_kind("static")
     set_languages("cxx20")
     set_symbols("debug")   
-    set_exceptions("none")
     add_includedirs("include")
-    add_defines(
-        "NOMINMAX", 
-        "UNICODE",
-        "_HAS_CXX23=1",
-        "_AMD64_"
-    )
-    add_cxflags(
-        "/EHa", 
-        "/utf-8", 
-        "/W4", 
-        "/w44265", 
-        "/w44289", 
-        "/w44296", 
-        "/w45263", 
-        "/w44738", 
-        "/w45204", 
-        "/O2", 
-        "/Ob3", 
-        "/Gy", 
-        "/GF"
-    )
-    add_ldflags(
-        "/OPT:REF", 
-        "/OPT:ICF"
-    )
     add_files("src/**.cpp")
     add_packages(
         "fmt",
         "magic_enum",
-        "detours",
         "libhat"
-    )
\ No newline at end of file
+    )
+    if is_plat("windows") then
+        set_exceptions("none")
+        add_defines(
+            "NOMINMAX", 
+            "UNICODE",
+            "_HAS_CXX23=1",
+            "_AMD64_"
+        )
+        add_cxflags(
+            "/EHa", 
+            "/utf-8", 
+            "/W4", 
+            "/w44265", 
+            "/w44289", 
+            "/w44296", 
+            "/w45263", 
+            "/w44738", 
+            "/w45204", 
+            "/O2", 
+            "/Ob3", 
+            "/Gy", 
+            "/GF"
+        )
+        add_ldflags(
+            "/OPT:REF", 
+            "/OPT:ICF"
+        )
+        add_packages("detours")
+    else
+        add_cxflags(
+            "-Wall", 
+            "-O2", 
+            "-fPIC"
+        )
+        add_syslinks("dl", "pthread")
+    end
+
+target("GlacieTraceDecoder")
+    set_kind("binary")
+    set_languages("cxx20")
+    add_includedirs("include")
+    add_defines(
+        "NOMINMAX", 
+        "UNICODE"
+    )
+    if is_plat("windows") then
+        set_exceptions("none")
+        add_cxflags("/utf-8")
+    end
+    add_files("tools/trace_decoder/main.cpp")
+    add_deps("GlacieHook")
+    add_packages("fmt")
+
+target("GlacieOffsetResolver")
+    set_kind("binary")
+    set_languages("cxx20")
+    add_includedirs("include")
+    add_defines(
+        "NOMINMAX", 
+        "UNICODE"
+    )
+    if is_plat("windows") then
+        set_exceptions("none")
+        add_cxflags("/utf-8")
+    end
+    add_files("tools/offset_resolver/main.cpp")
+    add_deps("GlacieHook")
+    add_packages("fmt")
+
+-- Linux only: xmake test runs the tests, xmake build -g bench builds the benchmarks for xmake run <name>
+if is_plat("linux") then
+    -- loaded by DeferredHookTest from the directory of its executable
+    target("DeferredHookModule")
+        set_kind("shared")
+        set_default(false)
+        set_group("test")
+        add_files("test/module/DeferredHookModule.cpp")
+
+    for _, group in ipairs({"test", "bench"}) do
+        for _, file in ipairs(os.files(group .. "/*.cpp")) do
+            target(path.basename(file))
+                set_kind("binary")
+                set_default(false)
+                set_group(group)
+                set_languages("cxx20")
+                add_includedirs("include")
+                add_files(file)
+                add_deps("GlacieHook")
+                add_packages(
+                    "fmt",
+                    "magic_enum",
+                    "libhat"
+                )
+                if group == "test" then
+                    add_tests("default")
+                end
+                if path.basename(file) == "DeferredHookTest" then
+                    add_deps("DeferredHookModule")
+                end
+        end
+    end
+end
\ No newline at end of file